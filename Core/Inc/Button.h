@@ -10,49 +10,109 @@
 
 #include "main.h"
 #include "cmsis_os.h"
+#include "Debounce.h"
+#include "ButtonEvent.h"
 
-typedef enum {
-  BTN_1 = 0,
-  BTN_2,
-  BTN_3,
-  TOTAL_BTNS
-}BTN_id_e;
-
-typedef enum {
-  // NO_BTN_EVENT = 0,
-  SINGLE_PRESS = 0, // Press and release within 300 ms
-  DOUBLE_PRESS, // Two presses within 500 ms
-  TRIPLE_PRESS, // Three presses within 700 ms
-  LONG_PRESS, // Hold longer than 1500 ms
-  TOTAL_BTN_EVENTS
-}BTN_event_e;
+// Input mode: 1 = EXTI edges wake the input task,
+// 0 = polled from BUTTON_SOURCE
+#define BUTTON_USE_EXTI 1
 
+// Polled input sources (BUTTON_USE_EXTI 0)
+#define BUTTON_SOURCE_PORT_DMA 0  // TIM1 triggers DMA snapshots of the port, processed in batches
+#define BUTTON_SOURCE_SHIFT_IN 1  // Cascaded 74HC165 registers, scanned every BUTTON_SAMPLE_MS
+#define BUTTON_SOURCE_MATRIX   2  // Row/column keypad, scanned every BUTTON_SAMPLE_MS
+#define BUTTON_SOURCE BUTTON_SOURCE_PORT_DMA
+
+// Starting debounce window, each button then adapts its own to the bounce
+// it shows, within DEBOUNCE_MIN_MS..DEBOUNCE_MAX_MS
+#define DEBOUNCE_MS 30
+#define DEBOUNCE_MIN_MS 5
+#define DEBOUNCE_MAX_MS 60
+// Quiet time kept on top of the longest recent bounce
+#define DEBOUNCE_MARGIN_MS 4
+
+// Polled sample period (TIM1 update rate, or scan period); the debounce window in samples
+// is the window in ms / BUTTON_SAMPLE_MS (at most DEBOUNCE_MAX_LIMIT)
+#define BUTTON_SAMPLE_MS 1
+
+// Bounce histogram, BUTTON_BOUNCE_BUCKET_MS wide buckets, the last one
+// also counts everything longer
+#define BUTTON_BOUNCE_BUCKETS 16
+#define BUTTON_BOUNCE_BUCKET_MS 2
+
+// Inputs per bank, one Debounce_t word
+#define BUTTON_BANK_PINS 32
+#define BUTTON_BANK_NONE 0xFF
+
+// What a button has taught the debouncer about its contacts
 typedef struct {
-  BTN_id_e id;
-  BTN_event_e type;
-  uint32_t timestamp;
-}BTN_event_t;
+  uint16_t debounce_ms;   // Window in use
+  uint16_t learned_ms;    // Recent bounce peak, jumps up at once and decays slowly
+  uint16_t max_ms;        // Longest bounce ever seen
+  uint32_t bursts;        // Edges measured
+  uint32_t late_bounces;  // Bounces that came after the window had already closed
+  uint32_t histogram[BUTTON_BOUNCE_BUCKETS];
+}Button_bounce_stats_t;
 
 typedef struct {
   BTN_id_e id;
   GPIO_TypeDef * port;
-  uint16_t pin;
-  
-  // State Tracking
-  GPIO_PinState last_state;           // Last read GPIO level (for edge detection)
-  uint32_t last_time;       // Timestamp of the last state change (for debounce/hold)
-  
-  // Multi-press Tracking
-  int click_count;          // How many clicks recorded so far
-  uint32_t first_click_time;// When the very first click in a sequence started
-  bool is_long_press_sent;  // Flag to prevent sending multiple Long Press events while holding
-
-  GPIO_PinState last_raw_state; // The actual pin level last read
-  uint32_t debounce_time;      // The last time the pin physically moved
-  osMessageQueueId_t queue_handler;
+  uint32_t pin;                       // GPIO pin, or 1 << input of a scanned source
+
+  // Times are Clock_now_us() readings
+  volatile uint32_t edge_time;        // Latest raw edge (EXTI interrupt or DMA sample)
+  volatile uint32_t burst_start_time; // First raw edge since the level last settled
+  volatile bool is_bouncing;          // Raw edges seen since the level last settled
+  uint32_t settle_time;               // When the level last settled
+  Button_bounce_stats_t bounce;
 }Button_t;
 
-void Button_ctor(Button_t * const me, BTN_id_e id, GPIO_TypeDef * port, uint16_t pin,osMessageQueueId_t queue_handler);
-void Button_read(Button_t * const me);
+struct Gesture_s;
+
+// All buttons on one GPIO port, debounced together from a single IDR read
+typedef struct {
+  GPIO_TypeDef * port;
+  uint32_t pin_mask;                          // Pins (or scanned inputs) owned by the bank
+  Button_t * buttons;
+  uint8_t count;
+  uint8_t bit_to_button[BUTTON_BANK_PINS];    // Pin or input number -> buttons[] index
+  Debounce_t debounce;                        // Debounced level of every pin
+  uint32_t raw;                               // Polled: previous raw sample
+  uint32_t bouncing;                          // Polled: pins inside a bounce burst
+  struct Gesture_s * gesture;                 // Receives the debounced edges
+}Button_bank_t;
+
+// A NULL port makes pin the input's bit in a scanned bitmask
+void Button_ctor(Button_t * const me, BTN_id_e id, GPIO_TypeDef * port, uint32_t pin);
+
+// Stamp a raw edge, from the EXTI interrupt or a DMA sample
+void Button_edge_from_isr(Button_t * const me, uint32_t now);
+
+// Snapshot of the learned debounce window and bounce histogram
+void Button_get_bounce_stats(const Button_t * const me, Button_bounce_stats_t * out);
+
+// port NULL for a scanned source
+void Button_bank_ctor(Button_bank_t * const me, GPIO_TypeDef * port, Button_t * buttons, uint8_t count, struct Gesture_s * gesture);
+
+// DMA mode: a batch of port snapshots taken BUTTON_SAMPLE_MS apart, the last
+// one at now (us)
+void Button_bank_process(Button_bank_t * const me, const uint16_t *samples, uint16_t count, uint32_t now);
+
+// Scanned inputs (bank port NULL): one bitmask of every input, 0 = pressed
+void Button_bank_process_scan(Button_bank_t * const me, uint32_t sample, uint32_t now);
+
+// EXTI mode: take the snapshot of every button quiet for its own window as stable
+void Button_bank_settled(Button_bank_t * const me);
+void Button_bank_edge_from_isr(Button_bank_t * const me, uint16_t pin, uint32_t now);
+
+// EXTI mode: time in ms until the next bouncing button goes quiet,
+// osWaitForever when none is bouncing. now is in us, as for every call below.
+uint32_t Button_bank_settle_deadline_ms(Button_bank_t * const me, uint32_t now);
+
+// Earliest gesture decision due, osWaitForever when idle
+uint32_t Button_bank_next_deadline_ms(Button_bank_t * const me, uint32_t now);
+
+// Every button released and none bouncing, safe to stop the clocks
+bool Button_bank_is_idle(const Button_bank_t * const me);
 
 #endif /* BUTTON_H_ */
@@ -0,0 +1,75 @@
+/*
+ *  @file ButtonEvent.h
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef BUTTONEVENT_H_
+#define BUTTONEVENT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Button ids and events as the menu sees them. No HAL includes, so the
+// menu builds on a host (see Port.h).
+
+typedef enum {
+  BTN_1 = 0,
+  BTN_2,
+  BTN_3,
+  TOTAL_BTNS
+}BTN_id_e;
+
+typedef enum {
+  // NO_BTN_EVENT = 0,
+  SINGLE_PRESS = 0, // Press and release within 300 ms
+  DOUBLE_PRESS, // Two presses within 500 ms
+  TRIPLE_PRESS, // Three presses within 700 ms
+  LONG_PRESS, // Hold longer than 1500 ms
+  CHORD_PRESS, // Several buttons pressed together
+  SEQUENCE_PRESS, // Different buttons pressed one after another
+  REPEAT, // Still held, sent at an accelerating rate
+  TOTAL_BTN_EVENTS
+}BTN_event_e;
+
+typedef struct {
+  BTN_id_e id;
+  BTN_event_e type;
+  uint32_t timestamp; // Clock_now_us() of the edge or deadline behind the event
+  // Sent while a longer gesture may still follow: the next event either
+  // repeats it without the flag (confirmed) or replaces it (roll back first)
+  bool is_speculative;
+}BTN_event_t;
+
+// BTN_event_t packed in one word for delivery between tasks:
+// bits 0-3 id, 4-7 type, 8 is_speculative, 9-31 the timestamp's low
+// 23 bits (8.3 s of us, more than any event waits for its consumer)
+#define BTN_PACKED_ID_SHIFT   0
+#define BTN_PACKED_TYPE_SHIFT 4
+#define BTN_PACKED_SPEC_SHIFT 8
+#define BTN_PACKED_TIME_SHIFT 9
+#define BTN_PACKED_TIME_MASK  (0xFFFFFFFFUL >> BTN_PACKED_TIME_SHIFT)
+
+static inline uint32_t BTN_event_pack(const BTN_event_t *event) {
+  return ((uint32_t) event->id << BTN_PACKED_ID_SHIFT)
+      | ((uint32_t) event->type << BTN_PACKED_TYPE_SHIFT)
+      | ((uint32_t) event->is_speculative << BTN_PACKED_SPEC_SHIFT)
+      | ((event->timestamp & BTN_PACKED_TIME_MASK) << BTN_PACKED_TIME_SHIFT);
+}
+
+// now (Clock_now_us) restores the timestamp's high bits, assuming the
+// event is at most BTN_PACKED_TIME_MASK us old
+static inline void BTN_event_unpack(uint32_t packed, uint32_t now, BTN_event_t *event) {
+  event->id = (BTN_id_e) ((packed >> BTN_PACKED_ID_SHIFT) & 0x0FU);
+  event->type = (BTN_event_e) ((packed >> BTN_PACKED_TYPE_SHIFT) & 0x0FU);
+  event->is_speculative = ((packed >> BTN_PACKED_SPEC_SHIFT) & 1U) != 0;
+  uint32_t age = (now - (packed >> BTN_PACKED_TIME_SHIFT)) & BTN_PACKED_TIME_MASK;
+  event->timestamp = now - age;
+}
+
+// One bit per button and event type, TOTAL_BTNS * TOTAL_BTN_EVENTS must fit in 32
+#define BTN_EVENT_BIT(id, type) (1UL << ((id) * TOTAL_BTN_EVENTS + (type)))
+#define BTN_EVENTS_ALL 0xFFFFFFFFUL
+
+#endif /* BUTTONEVENT_H_ */
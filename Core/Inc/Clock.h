@@ -0,0 +1,40 @@
+/*
+ *  @file Clock.h
+ *
+ *  Created on: 23-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include "main.h"
+
+// TIM5 is the HAL timebase: a free-running 32-bit counter at 1 MHz, with
+// compare channel 1 raising the 1 ms HAL tick and the update (overflow)
+// interrupt extending the count to 64 bits
+#define CLOCK_TIM TIM5
+#define CLOCK_TICK_US 1000U
+
+#define CLOCK_MS_TO_US(ms) ((uint32_t) (ms) * 1000U)
+// Rounded up, so a deadline in ms never fires early
+#define CLOCK_US_TO_MS(us) (((uint32_t) (us) + 999U) / 1000U)
+
+// Microseconds since boot, wraps every ~71.6 minutes. A single register
+// read, so it is safe from any task or interrupt; compare two readings by
+// subtraction, never by magnitude.
+static inline uint32_t Clock_now_us(void) {
+	return CLOCK_TIM->CNT;
+}
+
+// Microseconds since boot, never wraps
+uint64_t Clock_now_us64(void);
+
+// TIM5 interrupt: counts overflows and raises the HAL tick. Clears the
+// flags it handles, so HAL_TIM_IRQHandler finds nothing left to do.
+void Clock_irq_handler(void);
+
+// Restart the HAL tick one period from now (after HAL_ResumeTick)
+void Clock_resume_tick(void);
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,39 @@
+/*
+ *  @file Debounce.h
+ *
+ *  Created on: 20-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+#include "main.h"
+
+// Bit planes of the vertical counter, limits range from 1 to
+// 2^DEBOUNCE_PLANES - 1 samples (63 ms at the 1 kHz button sample rate)
+#define DEBOUNCE_PLANES 6
+#define DEBOUNCE_MAX_LIMIT ((1U << DEBOUNCE_PLANES) - 1)
+
+// Debounces up to 32 inputs at once, one bit per input. Each bit position
+// owns a DEBOUNCE_PLANES-bit counter spread across the planes ("vertical"
+// counter), and its own limit stored the same way, so one update costs the
+// same for 1 or 32 inputs whatever their individual windows.
+typedef struct {
+	uint32_t counter[DEBOUNCE_PLANES]; // Consecutive samples differing from state
+	uint32_t limit[DEBOUNCE_PLANES];   // Samples needed to accept a change
+	uint32_t state;                    // Debounced level of every input
+} Debounce_t;
+
+void Debounce_ctor(Debounce_t * const me, uint32_t initial, uint32_t limit);
+
+// Change the number of stable samples needed by the inputs in mask
+void Debounce_set_limit(Debounce_t * const me, uint32_t mask, uint32_t limit);
+
+// Feed one raw sample, returns the bits whose debounced level changed
+uint32_t Debounce_update(Debounce_t * const me, uint32_t sample);
+
+// Accept the inputs in mask as already stable, returns changed bits
+uint32_t Debounce_force(Debounce_t * const me, uint32_t sample, uint32_t mask);
+
+#endif /* DEBOUNCE_H_ */
@@ -13,26 +13,126 @@
 #include "cmsis_os.h"
 #include "Menu.h"
 
+// Producer/consumer link to the display manager: messages live in a fixed
+// block pool and only their pointers travel through the queue. The display
+// manager frees each message once its frame has been latched.
+struct Display_channel_s {
+	osMessageQueueId_t queue;	// Carries Display_msg_t pointers
+	osMemoryPoolId_t pool;		// Display_msg_t blocks
+	uint32_t high_water;		// Most blocks in use at once
+	uint32_t alloc_failures;	// Allocations refused, pool exhausted
+	uint32_t send_failures;		// Messages dropped, queue full
+};
+
+// Log2 latency histogram: bucket 0 holds 0 us, bucket n holds [2^(n-1), 2^n) us
+#define DISPLAY_LATENCY_BUCKETS 20
+
+// Enqueue-to-latch latency statistics (all times in microseconds)
+typedef struct {
+	uint32_t count;                        // Frames measured
+	uint32_t last_us;                      // Latency of the most recent frame
+	uint32_t max_us;                       // Worst enqueue-to-latch latency
+	uint32_t queue_max_us;                 // Worst enqueue-to-dequeue time
+	uint32_t service_max_us;               // Worst dequeue-to-latch time
+	uint64_t queue_total_us;               // Sum of enqueue-to-dequeue times
+	uint64_t service_total_us;             // Sum of dequeue-to-latch times
+	uint32_t histogram[DISPLAY_LATENCY_BUCKETS];
+} Display_latency_stats_t;
+
+// Cost of one submission path
+typedef struct {
+	uint32_t messages;                     // Queue messages consumed
+	uint32_t frames;                       // Frames latched
+	uint64_t cycles;                       // CPU cycles spent, frame waits excluded
+} Display_path_stats_t;
+
+// Per-frame vs batched submission cost
+typedef struct {
+	Display_path_stats_t single;           // Display_update
+	Display_path_stats_t batch;            // Display_update_batch
+} Display_throughput_stats_t;
+
+// Fixed-rate render loop accounting
+typedef struct {
+	uint32_t frames;                       // Frame slots executed
+	uint32_t rendered;                     // Frames that latched new data
+	uint32_t coalesced;                    // Updates superseded before being latched
+	uint32_t overruns;                     // Frames whose work exceeded the budget
+	uint32_t skipped;                      // Frame slots lost to late wakeups
+	uint32_t budget_cycles;                // CPU cycles available per frame
+	uint32_t last_cycles;                  // Work done in the most recent frame
+	uint32_t max_cycles;                   // Worst frame
+	uint64_t total_cycles;                 // Sum over all frames
+} Display_frame_stats_t;
+
+// Inactivity power saving
+typedef enum {
+	DISPLAY_ACTIVE = 0,                    // Normal brightness
+	DISPLAY_DIMMING,                       // Ramping brightness down
+	DISPLAY_BLANKED                        // Output off, PWM timer stopped
+} Display_idle_state_e;
+
 // Display manager state structure
 typedef struct {
 	SN74HC595_t *shift_register;           // Pointer to shift register driver
-	osMessageQueueId_t update_queue;      // Queue for receiving display updates
+	Display_channel_t *channel;           // Queue and pool for receiving display updates
 	osMutexId_t hardware_mutex;            // Mutex for hardware access
 
 	// Current display state
 	uint16_t current_pattern;              // Currently displayed pattern
 	uint8_t current_brightness;            // Current brightness level
 	bool is_enabled;                       // Display on/off state
+
+	Display_latency_stats_t latency;       // Frame latency, guarded by hardware_mutex
+	Display_throughput_stats_t throughput; // Submission cost, guarded by hardware_mutex
+
+	// Fixed-rate mode (frame_rate_hz == 0 renders on arrival)
+	uint16_t frame_rate_hz;
+	uint32_t frame_period_ticks;
+	uint32_t next_frame_tick;
+	Display_update_data_t pending;         // Latest frame not yet latched
+	Display_msg_t *pending_msg;            // Message owning the pending frame, if any
+	uint32_t pending_dequeue_time;         // When the pending frame left the queue
+	bool is_pending_measured;              // Pending frame carries an enqueue stamp
+	bool is_dirty;                         // Pending frame differs from the latched one
+	Display_msg_t *batch_msg;              // Sequence being played frame by frame
+	uint8_t batch_index;
+	uint32_t batch_remaining_ms;
+	bool is_batch_active;
+	Display_frame_stats_t frame_stats;     // Guarded by hardware_mutex
+
+	// Inactivity dimming (idle_timeout_ms == 0 disables it)
+	uint32_t idle_timeout_ms;              // No input for this long starts the ramp
+	uint32_t dim_step_ms;                  // Time per brightness level on the ramp
+	uint32_t last_activity_tick;
+	uint32_t next_dim_tick;
+	uint8_t dim_level;                     // Brightness currently driven while dimming
+	Display_idle_state_e idle_state;
+	Display_idle_state_e woke_from;        // Wake not logged yet (DISPLAY_ACTIVE: none)
 } Display_Manager_t;
 
 
 void Display_ctor(Display_Manager_t *const me, SN74HC595_t *shift_reg,
-		osMessageQueueId_t queue, osMutexId_t mutex);
+		Display_channel_t *channel, osMutexId_t mutex);
+
+// Display channel, shared by all producers (no heap, never blocks).
+// Display_channel_alloc and Display_channel_send are declared in Menu.h.
+void Display_channel_ctor(Display_channel_t *const channel,
+		osMessageQueueId_t queue, osMemoryPoolId_t pool);
+void Display_channel_free(Display_channel_t *const channel, Display_msg_t *msg);
 
 
 bool Display_update(Display_Manager_t *const me,
 		const Display_update_data_t *update);
 
+// Play a sequence of frames under a single hardware acquisition
+bool Display_update_batch(Display_Manager_t *const me,
+		const Display_batch_t *batch);
+
+// Dispatch a display queue message to the matching update function and
+// return the message to the pool once latched
+bool Display_handle_message(Display_Manager_t *const me, Display_msg_t *msg);
+
 
 bool Display_set_pattern(Display_Manager_t *const me, uint16_t pattern);
 bool Display_set_brightness(Display_Manager_t *const me, uint8_t brightness);
@@ -48,4 +148,40 @@ void Display_get_state(Display_Manager_t *const me, uint16_t *pattern,
 
 bool Display_is_enabled(Display_Manager_t *const me);
 
+// Fixed-rate rendering: 0 Hz renders on arrival, otherwise the rate must
+// divide the kernel tick rate (e.g. 100/500/1000 Hz)
+bool Display_set_frame_rate(Display_Manager_t *const me, uint16_t rate_hz);
+uint16_t Display_get_frame_rate(Display_Manager_t *const me);
+void Display_render_frame(Display_Manager_t *const me);
+void Display_wait_next_frame(Display_Manager_t *const me);
+bool Display_get_frame_stats(Display_Manager_t *const me,
+		Display_frame_stats_t *stats);
+
+// Inactivity dimming: after idle_timeout_ms without input the brightness
+// ramps down one level per dim_step_ms, then the output is blanked and the
+// PWM timer stopped. Any activity restores the previous state at once.
+void Display_set_idle_timeout(Display_Manager_t *const me,
+		uint32_t idle_timeout_ms, uint32_t dim_step_ms);
+void Display_notify_activity(Display_Manager_t *const me);
+void Display_service_idle(Display_Manager_t *const me);
+uint32_t Display_idle_wait_ticks(Display_Manager_t *const me);
+Display_idle_state_e Display_get_idle_state(Display_Manager_t *const me);
+
+// Frame latency statistics (safe to call from any task)
+bool Display_get_latency_stats(Display_Manager_t *const me,
+		Display_latency_stats_t *stats);
+void Display_reset_latency_stats(Display_Manager_t *const me);
+uint32_t Display_latency_percentile(const Display_latency_stats_t *stats,
+		uint8_t percentile);
+
+// Submission throughput statistics (safe to call from any task)
+bool Display_get_throughput_stats(Display_Manager_t *const me,
+		Display_throughput_stats_t *stats);
+uint32_t Display_frames_per_second(const Display_path_stats_t *path);
+
+// Latch frames one acquisition each, then DISPLAY_BATCH_MAX_FRAMES per
+// acquisition, and log the cycles per frame of both; call before the
+// display loop starts
+void Display_benchmark_submission(Display_Manager_t *const me, uint16_t frames);
+
 #endif /* INC_DISPLAY_H_ */
@@ -0,0 +1,34 @@
+/*
+ *  @file EventRing.h
+ *
+ *  Created on: 27-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef EVENTRING_H_
+#define EVENTRING_H_
+
+#include "Port.h"
+
+// Single-producer single-consumer ring of 32-bit words. No locks and no
+// kernel object: the producer only writes tail, the consumer only writes
+// head, so one task can put while another gets.
+typedef struct {
+	uint32_t *buffer;
+	uint16_t mask;              // Size - 1, the size is a power of two
+	volatile uint16_t head;     // Free-running, written by the consumer
+	volatile uint16_t tail;     // Free-running, written by the producer
+} EventRing_t;
+
+// Returns false unless size is a power of two (at most 32768)
+bool EventRing_ctor(EventRing_t * const me, uint32_t *buffer, uint16_t size);
+
+// Producer side, false when full
+bool EventRing_put(EventRing_t * const me, uint32_t word);
+
+// Consumer side, false when empty
+bool EventRing_get(EventRing_t * const me, uint32_t *word);
+
+uint16_t EventRing_count(const EventRing_t * const me);
+
+#endif /* EVENTRING_H_ */
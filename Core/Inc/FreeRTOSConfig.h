@@ -89,7 +89,10 @@
 
 /* Software timer definitions. */
 #define configUSE_TIMERS                         1
-#define configTIMER_TASK_PRIORITY                ( 2 )
+/* osPriorityNormal1: above the application tasks (osPriorityNormal), so a
+   task blocked in a UART log cannot hold back the auto cycle, debounce or
+   gesture timers. The callbacks only set thread flags. */
+#define configTIMER_TASK_PRIORITY                ( 25 )
 #define configTIMER_QUEUE_LENGTH                 10
 #define configTIMER_TASK_STACK_DEPTH             256
 
@@ -0,0 +1,206 @@
+/*
+ *  @file Gesture.h
+ *
+ *  Created on: 22-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef GESTURE_H_
+#define GESTURE_H_
+
+#include "Port.h"
+#include "ButtonEvent.h"
+#include "EventRing.h"
+
+#define GESTURE_MAX_STROKES 4     // Strokes in one gesture
+#define GESTURE_MAX_STATES 32     // Compiled states, root included
+#define GESTURE_HOLD_MS 1500      // A stroke held longer than this is a hold
+#define GESTURE_STASH_DEPTH 2     // Events parked per button while the ring is full
+#define GESTURE_STASH_RETRY_MS 5  // Queue retry period while events are parked
+#define GESTURE_SPLIT_TAPS 8      // Taps kept per stroke for reporting button by button
+
+// Stroke tokens: the set of buttons pressed together plus a hold bit
+#define GESTURE_TOKENS (1U << (TOTAL_BTNS + 1))
+#define GESTURE_NONE 0xFF
+
+#define BTN_MASK(id) (1U << (id))
+
+// One press of a button set: everything pressed from the first press until
+// all are released. A hold completes as soon as GESTURE_HOLD_MS elapses.
+// A stroke of several buttons that no accepted chord starts (a rolling or
+// overlapping press) is split: every button reports its own tap, in press
+// order, or its own hold, timed from its own press.
+typedef struct {
+	uint8_t buttons;              // BTN_MASK bits, several bits make a chord
+	bool is_hold;
+} Gesture_stroke_t;
+
+#define GESTURE_TAP(mask)  { .buttons = (mask), .is_hold = false }
+#define GESTURE_HOLD(mask) { .buttons = (mask), .is_hold = true }
+
+// A gesture is a sequence of strokes, e.g.
+//   double press: { GESTURE_TAP(BTN_MASK(BTN_1)), GESTURE_TAP(BTN_MASK(BTN_1)) }
+//   chord:        { GESTURE_TAP(BTN_MASK(BTN_1) | BTN_MASK(BTN_3)) }
+//   sequence:     { GESTURE_TAP(BTN_MASK(BTN_1)), GESTURE_TAP(BTN_MASK(BTN_2)) }
+typedef struct {
+	BTN_id_e id;                  // Event reported when recognised
+	BTN_event_e type;
+	uint8_t length;
+	Gesture_stroke_t strokes[GESTURE_MAX_STROKES];
+	uint16_t gap_ms;              // Longest pause before each further stroke
+	uint16_t window_ms;           // Whole gesture, from the first press (0 = no limit)
+	uint16_t repeat_ms;           // Ending in a hold: re-emit while held (0 = once)
+} Gesture_def_t;
+
+// Hold-to-repeat for any single held button whose REPEAT the consumer
+// accepts: one REPEAT after delay_ms, then at intervals shrinking from
+// start_ms by step_percent each time, down to min_ms
+typedef struct {
+	uint16_t delay_ms;
+	uint16_t start_ms;
+	uint16_t min_ms;
+	uint8_t step_percent;
+} Gesture_repeat_cfg_t;
+
+// The table compiled into a trie of strokes, so each stroke costs one
+// lookup no matter how many gestures are defined
+typedef struct {
+	uint8_t next[GESTURE_MAX_STATES][GESTURE_TOKENS];
+	uint8_t accept[GESTURE_MAX_STATES];     // Gesture completed here, or GESTURE_NONE
+	bool has_next[GESTURE_MAX_STATES];      // Longer gestures continue from here
+	uint32_t beyond[GESTURE_MAX_STATES];    // BTN_EVENT_BITs of those longer gestures
+	uint16_t gap_ms[GESTURE_MAX_STATES];    // Pause that ends the wait for a next stroke
+	uint32_t window_ms[GESTURE_MAX_STATES]; // Time from the first press that ends it too
+	uint8_t state_count;
+} Gesture_machine_t;
+
+// Events that found the ring full, oldest at head
+typedef struct {
+	BTN_event_t events[GESTURE_STASH_DEPTH];
+	uint32_t seq[GESTURE_STASH_DEPTH];    // Emission order across all buttons
+	uint8_t head;
+	uint8_t count;
+} Gesture_stash_t;
+
+typedef struct {
+	uint32_t sent;                        // Put in the ring, directly or from the stash
+	uint32_t stashed;                     // Found the ring full and were parked
+	uint32_t dropped[TOTAL_BTN_EVENTS];   // Lost with their button's stash full, per type
+	uint8_t stash_high_water;             // Most events parked at once
+} Gesture_emit_stats_t;
+
+// Event timestamp to Gesture_receive, in us
+typedef struct {
+	uint32_t count;
+	uint32_t last_us;
+	uint32_t max_us;
+	uint64_t total_us;
+} Gesture_latency_stats_t;
+
+// Control events (power off/on) get their own ring, read before
+// any navigation event, so they never wait behind a navigation backlog
+typedef enum {
+	GESTURE_LANE_CONTROL = 0,
+	GESTURE_LANE_NAV,
+	GESTURE_LANES
+} Gesture_lane_e;
+
+typedef struct {
+	EventRing_t *ring;            // Packed events (BTN_event_pack)
+	Gesture_stash_t stash[TOTAL_BTNS];
+	uint8_t stash_count;
+	Gesture_emit_stats_t emit_stats;      // Written by the producer
+	Gesture_latency_stats_t latency;      // Written by the consumer
+} Gesture_lane_t;
+
+typedef struct Gesture_s {
+	const Gesture_def_t *defs;
+	uint8_t def_count;
+	Gesture_machine_t machine;
+
+	uint8_t state;                // Current trie node, 0 = root
+	uint8_t held;                 // Buttons currently down
+	uint8_t stroke;               // Buttons pressed during the current stroke
+	bool is_hold_sent;            // Current stroke already fed as a hold
+	bool is_split;                // Current stroke reported button by button
+	uint8_t hold_fed;             // Held buttons already fed as their own hold
+	uint8_t tap_count;
+	uint8_t taps[GESTURE_SPLIT_TAPS];     // Buttons released as taps, in press order
+	uint32_t tap_times[GESTURE_SPLIT_TAPS];
+	// Times are Port_now_us() readings, the table and config are in ms
+	uint32_t down_time[TOTAL_BTNS];   // Press of each held button
+	uint32_t first_press_time;    // First press of the gesture in progress
+	uint32_t stroke_time;         // First press of the current stroke
+	uint32_t press_time;          // Latest press of the current stroke
+	uint32_t release_time;        // End of the previous stroke
+
+	uint8_t speculative_def;      // Reported ahead of a possible longer gesture, or GESTURE_NONE
+	uint8_t repeat_def;           // Hold gesture being repeated, or GESTURE_NONE
+	uint32_t next_repeat_time;
+
+	const Gesture_repeat_cfg_t *key_repeat_cfg; // NULL disables REPEAT
+	uint8_t key_repeat_id;        // Button sending REPEAT, or GESTURE_NONE
+	uint16_t key_repeat_interval; // ms
+	uint32_t next_key_repeat_time;
+
+	// BTN_EVENT_BITs the consumer currently acts on, written by another task.
+	// A gesture is reported without waiting when nothing longer is wanted.
+	volatile uint32_t accepted_events;
+
+	// Emission never blocks: events a lane has no room for wait in its stash
+	Gesture_lane_t lanes[GESTURE_LANES];
+	uint32_t stash_seq;
+	volatile uint32_t control_events; // BTN_EVENT_BITs sent on the control lane
+	bool is_speculation_open;     // Last event sent was speculative
+	Port_thread_t consumer;       // Woken with consumer_flag after every put
+	uint32_t consumer_flag;
+	Port_thread_t owner;          // Feeds edges and ticks, woken with owner_flag
+	uint32_t owner_flag;          // when the accepted set shrinks
+} Gesture_t;
+
+// Compiles the table, returns false if it does not fit GESTURE_MAX_STATES.
+// control_ring may be NULL to send everything on the navigation lane.
+bool Gesture_ctor(Gesture_t * const me, const Gesture_def_t *defs, uint8_t def_count,
+		const Gesture_repeat_cfg_t *key_repeat_cfg, EventRing_t *control_ring,
+		EventRing_t *nav_ring);
+
+// Classify events as control (BTN_EVENT_BITs); everything else is navigation
+void Gesture_set_control_events(Gesture_t * const me, uint32_t events);
+
+// Thread to wake with flag whenever an event is queued on either lane
+void Gesture_set_consumer(Gesture_t * const me, Port_thread_t thread, uint32_t flag);
+
+// Thread calling Gesture_edge and Gesture_tick, woken with flag when
+// Gesture_set_accepted drops events, so a gesture that was waiting on one
+// is reported on that tick rather than when its press window closes. Not
+// needed when the owner already ticks at a fixed rate.
+void Gesture_set_owner(Gesture_t * const me, Port_thread_t thread, uint32_t flag);
+
+// Consumer side, never blocks: the next control event, else the next
+// navigation event. Returns false when both lanes are empty.
+bool Gesture_receive(Gesture_t * const me, BTN_event_t *event);
+
+// Publish which events the consumer handles, BTN_EVENTS_ALL to wait for
+// every longer gesture
+void Gesture_set_accepted(Gesture_t * const me, uint32_t events);
+
+// Debounced level change of one button at edge_time (us)
+void Gesture_edge(Gesture_t * const me, BTN_id_e id, bool is_pressed, uint32_t edge_time);
+
+// Close holds, timing windows and repeats that are due at now (us)
+void Gesture_tick(Gesture_t * const me, uint32_t now);
+
+// Time until Gesture_tick has work, rounded up to ms; PORT_WAIT_FOREVER when idle
+uint32_t Gesture_next_deadline_ms(Gesture_t * const me, uint32_t now);
+
+// Snapshots of one lane's emission counters and latency
+void Gesture_get_emit_stats(const Gesture_t * const me, Gesture_lane_e lane, Gesture_emit_stats_t *out);
+void Gesture_get_latency_stats(const Gesture_t * const me, Gesture_lane_e lane, Gesture_latency_stats_t *out);
+
+#if !defined(PORT_HOST)
+// Time runs put/get round trips of one event through a CMSIS queue and
+// through a packed ring, and log the cycles per event for each
+void Gesture_benchmark_delivery(uint16_t runs);
+#endif
+
+#endif /* GESTURE_H_ */
@@ -0,0 +1,47 @@
+/*
+ *  @file InputScan.h
+ *
+ *  Created on: 24-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef INPUTSCAN_H_
+#define INPUTSCAN_H_
+
+#include "main.h"
+
+#define INPUT_SCAN_MAX_INPUTS 64
+#define INPUT_SCAN_WORDS ((INPUT_SCAN_MAX_INPUTS + 31) / 32)
+
+// Reads every input once: bit n of words[n / 32] is input n, 0 = pressed,
+// the same polarity as the active-low GPIO buttons
+typedef void (*InputScan_read_fn)(void *ctx, uint32_t *words);
+
+// Cost of a full scan in DWT cycles
+typedef struct {
+	uint32_t scans;
+	uint32_t last_cycles;
+	uint32_t max_cycles;
+	uint64_t total_cycles;
+} InputScan_stats_t;
+
+// A polled input chain (shift-in registers, key matrix, ...) behind one
+// bitmask interface, so the button bank does not care how inputs are wired
+typedef struct {
+	const char *name;
+	InputScan_read_fn read;
+	void *ctx;
+	uint16_t inputs;
+	InputScan_stats_t stats;
+} InputScan_t;
+
+void InputScan_ctor(InputScan_t * const me, const char *name,
+		InputScan_read_fn read, void *ctx, uint16_t inputs);
+
+// One timed scan into words (INPUT_SCAN_WORDS long)
+void InputScan_read(InputScan_t * const me, uint32_t *words);
+
+// Time runs back-to-back scans and log the cost per scan and per input
+void InputScan_benchmark(InputScan_t * const me, uint16_t runs);
+
+#endif /* INPUTSCAN_H_ */
@@ -0,0 +1,47 @@
+/*
+ *  @file KeyMatrix.h
+ *
+ *  Created on: 24-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef KEYMATRIX_H_
+#define KEYMATRIX_H_
+
+#include "main.h"
+#include "InputScan.h"
+
+#define KEYMATRIX_MAX_ROWS 8
+#define KEYMATRIX_MAX_COLS 8
+
+typedef struct {
+	GPIO_TypeDef *port;
+	uint16_t pin;
+} KeyMatrix_pin_t;
+
+// Row/column keypad. Rows are open-drain outputs driven low one at a time;
+// columns are pulled-up inputs on consecutive pins of one port, so each row
+// costs a single IDR read. Input n is row n / cols, column n % cols.
+// Without a diode per key, three keys on a rectangle ghost a fourth.
+typedef struct {
+	const KeyMatrix_pin_t *rows;
+	uint8_t row_count;
+
+	GPIO_TypeDef *col_port;
+	uint8_t col_first;           // Pin number of column 0
+	uint8_t col_count;
+
+	uint16_t settle_cycles;      // Wait after selecting a row, for line capacitance
+} KeyMatrix_t;
+
+// Also configures the row and column pins, which are not part of the
+// CubeMX project
+void KeyMatrix_ctor(KeyMatrix_t * const me,
+                    const KeyMatrix_pin_t *rows, uint8_t row_count,
+                    GPIO_TypeDef *col_port, uint8_t col_first, uint8_t col_count,
+                    uint16_t settle_cycles);
+
+// Scan every row (InputScan_read_fn, ctx = KeyMatrix_t)
+void KeyMatrix_scan(void *ctx, uint32_t *words);
+
+#endif /* KEYMATRIX_H_ */
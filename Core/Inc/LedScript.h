@@ -0,0 +1,135 @@
+/*
+ *  @file LedScript.h
+ *
+ *  Created on: 01-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef LEDSCRIPT_H_
+#define LEDSCRIPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Stack machine for LED animations. A program drives two output registers,
+// the pattern and the brightness, and hands a frame over at every WAIT.
+// Values are 16 bits, one per LED. Jump targets are byte offsets, so a
+// program is at most LED_SCRIPT_MAX_CODE bytes.
+
+#define LED_SCRIPT_MAX_CODE       256
+#define LED_SCRIPT_STACK_DEPTH    8
+#define LED_SCRIPT_COUNTERS       4
+#define LED_SCRIPT_STEP_OPS       32    // Instructions per step, bounds its cycles
+#define LED_SCRIPT_WAIT_UNIT_MS   10
+#define LED_SCRIPT_MAX_BRIGHTNESS 10    // Display levels 0-10
+
+typedef enum {
+	LS_OP_END,      // Stop, the last frame stays
+	LS_OP_PUSH,     // imm16 (little endian)
+	LS_OP_PUSHC,    // c: push counter c
+	LS_OP_DUP,
+	LS_OP_DROP,
+	LS_OP_GET,      // Push the pattern register
+	LS_OP_PATTERN,  // Pop into the pattern register
+	LS_OP_BRIGHT,   // Pop into the brightness register, clamped
+	LS_OP_SHL,      // imm8 shift of the top value
+	LS_OP_SHR,
+	LS_OP_ROL,      // imm8 rotate of the top value, 16 bits
+	LS_OP_ROR,
+	LS_OP_AND,      // Pop two, push one
+	LS_OP_OR,
+	LS_OP_XOR,
+	LS_OP_ADD,      // Wraps at 16 bits
+	LS_OP_RAND,     // Push a pseudo-random value
+	LS_OP_WAIT,     // imm8: emit the frame, resume after imm8 * LED_SCRIPT_WAIT_UNIT_MS
+	LS_OP_SETC,     // c, imm8: load counter c
+	LS_OP_DJNZ,     // c, addr: decrement counter c, jump while not zero
+	LS_OP_JZ,       // addr: pop, jump if zero
+	LS_OP_JMP,      // addr
+	TOTAL_LS_OPS
+} LedScript_op_e;
+
+// Assembler helpers for programs kept in flash
+#define LS_END()          LS_OP_END
+#define LS_PUSH(v)        LS_OP_PUSH, (uint8_t) ((v) & 0xFF), (uint8_t) ((v) >> 8)
+#define LS_PUSHC(c)       LS_OP_PUSHC, (c)
+#define LS_DUP()          LS_OP_DUP
+#define LS_DROP()         LS_OP_DROP
+#define LS_GET()          LS_OP_GET
+#define LS_PATTERN()      LS_OP_PATTERN
+#define LS_BRIGHT()       LS_OP_BRIGHT
+#define LS_SHL(n)         LS_OP_SHL, (n)
+#define LS_SHR(n)         LS_OP_SHR, (n)
+#define LS_ROL(n)         LS_OP_ROL, (n)
+#define LS_ROR(n)         LS_OP_ROR, (n)
+#define LS_AND()          LS_OP_AND
+#define LS_OR()           LS_OP_OR
+#define LS_XOR()          LS_OP_XOR
+#define LS_ADD()          LS_OP_ADD
+#define LS_RAND()         LS_OP_RAND
+#define LS_WAIT(units)    LS_OP_WAIT, (units)
+#define LS_SETC(c, n)     LS_OP_SETC, (c), (n)
+#define LS_DJNZ(c, addr)  LS_OP_DJNZ, (c), (addr)
+#define LS_JZ(addr)       LS_OP_JZ, (addr)
+#define LS_JMP(addr)      LS_OP_JMP, (addr)
+
+typedef enum {
+	LED_SCRIPT_WAIT,    // Frame ready, run again after wait_ms
+	LED_SCRIPT_YIELD,   // Step budget used up without a WAIT, frame ready
+	LED_SCRIPT_DONE,    // END reached
+	LED_SCRIPT_FAULT    // Stack over/underflow, the program is stopped
+} LedScript_status_e;
+
+typedef struct {
+	const char *name;
+	const uint8_t *code;
+	uint16_t length;
+} LedScript_program_t;
+
+typedef struct {
+	uint32_t steps;
+	uint32_t ops;
+	uint32_t yields;            // Steps cut short by LED_SCRIPT_STEP_OPS
+	uint32_t faults;
+	uint8_t max_ops;            // Most instructions in one step
+	uint32_t max_cycles;        // Slowest step in DWT cycles
+} LedScript_stats_t;
+
+typedef struct {
+	const uint8_t *code;
+	uint16_t length;
+	uint16_t pc;
+	uint8_t sp;
+	bool is_stopped;
+	uint16_t stack[LED_SCRIPT_STACK_DEPTH];
+	uint8_t counters[LED_SCRIPT_COUNTERS];
+	uint32_t random;            // xorshift32 state, never 0
+	uint16_t pattern;           // Output registers
+	uint8_t brightness;
+	uint16_t wait_ms;           // Set by a step that returns LED_SCRIPT_WAIT
+	LedScript_stats_t stats;
+} LedScript_t;
+
+// Built-in programs in flash
+extern const LedScript_program_t LED_SCRIPT_BUILTINS[];
+extern const uint8_t LED_SCRIPT_BUILTIN_COUNT;
+
+// Checks every opcode, operand and jump target once, so stepping only has
+// to guard the stack. Safe on untrusted (uploaded) code.
+bool LedScript_verify(const uint8_t *code, uint16_t length);
+
+// Verifies, then starts from the top with an empty stack. The code is not
+// copied and has to outlive the script.
+bool LedScript_load(LedScript_t * const me, const uint8_t *code, uint16_t length,
+		uint8_t brightness, uint32_t seed);
+
+// Runs up to LED_SCRIPT_STEP_OPS instructions, to the next WAIT at most
+LedScript_status_e LedScript_step(LedScript_t * const me);
+
+void LedScript_get_stats(const LedScript_t * const me, LedScript_stats_t *out);
+
+// Times the scanner program against the same animation in C and checks
+// that both produce the same frames
+void LedScript_benchmark(uint16_t frames);
+
+#endif /* LEDSCRIPT_H_ */
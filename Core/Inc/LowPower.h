@@ -0,0 +1,40 @@
+/*
+ *  @file LowPower.h
+ *
+ *  Created on: 31-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef LOWPOWER_H_
+#define LOWPOWER_H_
+
+#include "main.h"
+#include <stdbool.h>
+
+// RTC backup registers used: BKP0R marker, then the state words, then a
+// check word. They survive STOP and any reset short of losing power.
+#define LOW_POWER_STATE_WORDS 8
+#define LOW_POWER_MAGIC 0x0FF5A7E0UL
+
+typedef struct {
+	uint32_t stops;             // Times STOP mode was entered
+	uint32_t last_resume_us;    // Wake-up to clocks and tick back, last time
+	uint32_t max_resume_us;
+	uint32_t wake_time;         // Clock_now_us() once resumed
+} LowPower_stats_t;
+
+// Keep state in the backup registers, count at most LOW_POWER_STATE_WORDS
+void LowPower_save(const uint32_t *words, uint8_t count);
+
+// False if the registers hold no state (cold boot, or cleared)
+bool LowPower_load(uint32_t *words, uint8_t count);
+void LowPower_clear(void);
+
+// STOP mode until an EXTI line fires. RAM, registers and the PLL
+// configuration are kept, so resuming only restarts HSE and the PLL;
+// the waking interrupt runs once the clocks are back.
+void LowPower_stop(void);
+
+void LowPower_get_stats(LowPower_stats_t *out);
+
+#endif /* LOWPOWER_H_ */
@@ -8,9 +8,10 @@
 #ifndef INC_MENU_H_
 #define INC_MENU_H_
 
-#include "main.h"
-#include "Button.h"
-#include "cmsis_os.h"
+#include "Port.h"
+#include "ButtonEvent.h"
+#include "SettingsStore.h"
+#include "LedScript.h"
 
 typedef enum{
 	BRIGHTNESS_PAGE = 0,
@@ -24,25 +25,157 @@ typedef enum{
 	AUTO_MODE,
 	FIRMWARE_VER,
 	RESET_CONFIRM,
+	POWER_OFF,
 	TOTAL_PAGES
 }Menu_State_e;
 
 typedef struct{
 	uint16_t data;
 	uint8_t brightness;
+	uint32_t timestamp; // Clock_now_us() when the update was enqueued
 }Display_update_data_t;
 
+#define DISPLAY_BATCH_MAX_FRAMES	8
+// Words needed to resume the menu without the settings store
+#define MENU_SNAPSHOT_WORDS			3
+
+typedef struct{
+	uint16_t data;
+	uint8_t brightness;
+	uint16_t duration_ms; // Time the frame stays latched before the next one
+}Display_frame_t;
+
+typedef struct{
+	uint8_t count;
+	uint32_t timestamp; // Clock_now_us() when the batch was enqueued
+	Display_frame_t frames[DISPLAY_BATCH_MAX_FRAMES];
+}Display_batch_t;
+
+typedef enum{
+	DISPLAY_MSG_UPDATE = 0,
+	DISPLAY_MSG_BATCH,
+	DISPLAY_MSG_ACTIVITY, // User input seen, restarts the inactivity timer
+	TOTAL_DISPLAY_MSGS
+}Display_msg_type_e;
+
+// Display message, allocated from the display pool
+typedef struct{
+	Display_msg_type_e type;
+	union{
+		Display_update_data_t update;
+		Display_batch_t batch;
+	};
+}Display_msg_t;
+
+// Link to the display manager, defined in Display.h. The menu only
+// allocates and sends through it, so a host build can supply its own.
+typedef struct Display_channel_s Display_channel_t;
+
+// NULL when the pool is exhausted
+Display_msg_t *Display_channel_alloc(Display_channel_t *const channel);
+bool Display_channel_send(Display_channel_t *const channel, Display_msg_t *msg);
+
+// Menu state variables
+typedef struct{
+	uint8_t brightness;
+	uint8_t current_pattern_index;
+	bool is_auto_mode;
+	Menu_State_e saved_mode_selection; // To track Manual vs Auto in Mode Select
+	uint16_t auto_period_ms;
+	uint8_t auto_script; // 0 cycles the patterns, n plays LED_SCRIPT_BUILTINS[n - 1], then the uploaded one
+}Menu_Settings_t;
+
+// A speculative event is applied at once; this is the state to return to
+// if a longer gesture replaces it
+typedef struct{
+	bool is_active;
+	BTN_event_t event;
+	uint16_t pattern;
+	Menu_State_e current_page;
+	Menu_Settings_t settings;
+}Menu_Speculation_t;
+
+// Events applied back to back between Menu_begin_batch and Menu_end_batch
+// draw only their final frame
+typedef struct{
+	bool is_active;
+	uint8_t events;
+	bool is_activity_pending;
+	bool is_frame_pending;
+	uint16_t pattern;			// Last frame asked for
+	uint8_t brightness;
+}Menu_batch_t;
+
+typedef struct{
+	uint32_t batches;			// Batches of more than one event
+	uint32_t events;			// Events applied inside batches
+	uint32_t frames_skipped;	// Intermediate frames never sent
+	uint32_t logs_skipped;		// Intermediate log lines not printed
+	uint8_t max_events;			// Largest batch
+}Menu_batch_stats_t;
+
+// Cost of the transition lookup and its action in DWT cycles, frames and
+// logging not included
+typedef struct{
+	uint32_t dispatches;
+	uint32_t last_cycles;
+	uint32_t max_cycles;
+	uint64_t total_cycles;
+}Menu_dispatch_stats_t;
+
 typedef struct {
 	uint16_t pattern;
 	Menu_State_e current_page;
-	osMessageQueueId_t queue_handler;
+	Display_channel_t *display_channel;
+	SettingsStore_t *store;		// NULL: settings reset on every boot
+	Menu_Settings_t settings;
+	Menu_Speculation_t speculation;
+	Menu_batch_t batch;
+	Menu_batch_stats_t batch_stats;
+	Menu_dispatch_stats_t dispatch_stats;
+	LedScript_t script;
+	uint8_t script_loaded;		// auto_script the interpreter runs, 0 = none
+	uint32_t script_due;		// ms, next step
+	uint8_t uploaded[LED_SCRIPT_MAX_CODE];
+	uint16_t uploaded_length;	// 0 = nothing uploaded
 }Menu_t;
 
-void Menu_ctor(Menu_t * const me, osMessageQueueId_t queue_handler);
+// Restores the saved settings from store, if any
+void Menu_ctor(Menu_t * const me, Display_channel_t *display_channel, SettingsStore_t *store);
+// Picks up from a Menu_get_snapshot taken before power-off: draws the saved
+// page and stays quiet otherwise. False, with defaults set, on a bad snapshot
+bool Menu_resume_ctor(Menu_t * const me, Display_channel_t *display_channel, SettingsStore_t *store,
+		const uint32_t *words);
+void Menu_get_snapshot(const Menu_t * const me, uint32_t *words);
 void Menu_process_input(Menu_t * const me, const BTN_event_t event);
 
+// Fast-forward through several queued events: frames and log lines from
+// the events in between are counted, only the final frame is sent
+void Menu_begin_batch(Menu_t * const me);
+void Menu_end_batch(Menu_t * const me);
+void Menu_get_batch_stats(const Menu_t * const me, Menu_batch_stats_t *out);
+void Menu_get_dispatch_stats(const Menu_t * const me, Menu_dispatch_stats_t *out);
+
+// BTN_EVENT_BITs the current page acts on, for Gesture_set_accepted; while
+// a speculative press is open, also those of the page it was applied on
+uint32_t Menu_accepted_events(const Menu_t * const me);
+
+bool Menu_is_powered_off(const Menu_t * const me);
+
 // Additional helper functions
-bool Menu_is_auto_mode_active(void);
+bool Menu_is_auto_mode_active(const Menu_t * const me);
+// Auto mode speed, BTN2/BTN3 on the auto mode page halve/double it
+uint16_t Menu_auto_cycle_period_ms(const Menu_t * const me);
 void Menu_auto_cycle_pattern(Menu_t * const me);
 
+// Auto mode scripts, BTN1 double press on the auto mode page picks the next
+// one. Waits in a script scale with the auto mode speed.
+bool Menu_is_script_playing(const Menu_t * const me);
+// Starts, switches or steps the script when due; now in ms
+void Menu_script_service(Menu_t * const me, uint32_t now);
+// ms until Menu_script_service has work, PORT_WAIT_FOREVER if none
+uint32_t Menu_script_next_deadline_ms(const Menu_t * const me, uint32_t now);
+// Verifies and copies a program, playable after the built-in ones until reset
+bool Menu_upload_script(Menu_t * const me, const uint8_t *code, uint16_t length);
+
 #endif /* INC_MENU_H_ */
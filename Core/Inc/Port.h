@@ -0,0 +1,68 @@
+/*
+ *  @file Port.h
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef PORT_H_
+#define PORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The few hardware and RTOS hooks the portable modules (Menu, LedScript,
+// Gesture, EventRing) use. On the target they map straight to DWT, TIM5
+// and CMSIS-RTOS; with PORT_HOST defined they are functions supplied by
+// the host build (Host/port_host.c).
+
+#if defined(PORT_HOST)
+
+typedef void *Port_thread_t;
+
+#define PORT_WAIT_FOREVER 0xFFFFFFFFU
+
+// Host: nanoseconds, not core cycles
+uint32_t Port_cycles(void);
+uint32_t Port_now_us(void);
+// Host: a thread is a uint32_t of pending flags, flag is ORed into it
+void Port_notify(Port_thread_t thread, uint32_t flag);
+
+static inline void Port_barrier(void) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// As in Clock.h
+#define CLOCK_MS_TO_US(ms) ((uint32_t) (ms) * 1000U)
+#define CLOCK_US_TO_MS(us) (((uint32_t) (us) + 999U) / 1000U)
+
+#else
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "Clock.h"
+
+typedef osThreadId_t Port_thread_t;
+
+#define PORT_WAIT_FOREVER osWaitForever
+
+// DWT core cycle counter
+static inline uint32_t Port_cycles(void) {
+	return DWT->CYCCNT;
+}
+
+static inline uint32_t Port_now_us(void) {
+	return Clock_now_us();
+}
+
+static inline void Port_notify(Port_thread_t thread, uint32_t flag) {
+	osThreadFlagsSet(thread, flag);
+}
+
+static inline void Port_barrier(void) {
+	__DMB();
+}
+
+#endif
+
+#endif /* PORT_H_ */
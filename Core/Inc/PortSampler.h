@@ -0,0 +1,36 @@
+/*
+ *  @file PortSampler.h
+ *
+ *  Created on: 21-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef PORTSAMPLER_H_
+#define PORTSAMPLER_H_
+
+#include "main.h"
+#include "tim.h"
+
+// Snapshots a GPIO port's IDR into a circular buffer on every update event
+// of a timer, using the timer's update DMA request. No CPU time is spent
+// per sample; the owner drains the buffer in batches.
+typedef struct {
+	TIM_HandleTypeDef *htim;    // Paces the samples, update DMA linked by CubeMX
+	GPIO_TypeDef *port;
+	volatile uint16_t *buffer;  // Written by DMA, circular
+	uint16_t length;
+	uint16_t read_index;        // Next sample not yet handed out
+} PortSampler_t;
+
+void PortSampler_ctor(PortSampler_t * const me, TIM_HandleTypeDef *htim,
+		GPIO_TypeDef *port, volatile uint16_t *buffer, uint16_t length);
+
+// Start the timer and the circular DMA transfer
+bool PortSampler_start(PortSampler_t * const me);
+
+// Copy out up to max samples, oldest first, returns how many were copied.
+// Must be called at least once per buffer length of samples or old ones
+// are overwritten.
+uint16_t PortSampler_read(PortSampler_t * const me, uint16_t *out, uint16_t max);
+
+#endif /* PORTSAMPLER_H_ */
@@ -0,0 +1,44 @@
+/*
+ *  @file SN74HC165.h
+ *
+ *  Created on: 24-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef SN74HC165_H_
+#define SN74HC165_H_
+
+#include "main.h"
+#include "InputScan.h"
+
+#define SN74HC165_MAX_CHIPS (INPUT_SCAN_MAX_INPUTS / 8)
+
+// Cascaded parallel-in/serial-out registers. Chip 0 is the one whose QH
+// reaches the MCU; input n is chip n / 8, pin D(n % 8). CLK INH is tied low.
+typedef struct {
+	// Shift/Load, loads the parallel inputs while low
+	GPIO_TypeDef *load_port;
+	uint16_t load_pin;
+
+	// Serial clock, shifts on the rising edge
+	GPIO_TypeDef *clk_port;
+	uint16_t clk_pin;
+
+	// QH of chip 0
+	GPIO_TypeDef *data_port;
+	uint16_t data_pin;
+
+	uint8_t chip_count;
+} SN74HC165_t;
+
+// Also configures the three pins, which are not part of the CubeMX project
+void SN74HC165_ctor(SN74HC165_t * const me,
+                    GPIO_TypeDef *load_port, uint16_t load_pin,
+                    GPIO_TypeDef *clk_port, uint16_t clk_pin,
+                    GPIO_TypeDef *data_port, uint16_t data_pin,
+                    uint8_t chip_count);
+
+// Latch and shift in every input (InputScan_read_fn, ctx = SN74HC165_t)
+void SN74HC165_read(void *ctx, uint32_t *words);
+
+#endif /* SN74HC165_H_ */
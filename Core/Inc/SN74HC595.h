@@ -34,6 +34,7 @@ typedef struct {
 	// Current state
 	uint16_t current_data;
 	uint8_t current_brightness;
+	uint32_t last_latch_time; // Clock_now_us() of the last RCLK pulse
 } SN74HC595_t;
 
 // Constructor - Initialize the shift register
@@ -62,4 +63,14 @@ void SN74HC595_disable_output(SN74HC595_t * const me);
 // Turn on LEDs (restore brightness)
 void SN74HC595_enable_output(SN74HC595_t * const me);
 
+// Stop the PWM timer with OE held HIGH (LEDs off, no timer activity)
+void SN74HC595_stop_pwm(SN74HC595_t * const me);
+
+// Restart the PWM timer (output stays off until brightness is set)
+void SN74HC595_start_pwm(SN74HC595_t * const me);
+
+// Restart the PWM timer and restore brightness without logging, for the
+// wake path where the next frame should not wait on the UART
+void SN74HC595_wake(SN74HC595_t * const me, uint8_t brightness);
+
 #endif /* SN74HC595_H_ */
@@ -0,0 +1,70 @@
+/*
+ *  @file ScanKeys.h
+ *
+ *  Created on: 03-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef SCANKEYS_H_
+#define SCANKEYS_H_
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "Debounce.h"
+#include "EventRing.h"
+#include "InputScan.h"
+
+// Fixed debounce window of the extra keys, in scans (BUTTON_SAMPLE_MS apart)
+#define SCAN_KEYS_DEBOUNCE_SAMPLES 20
+
+// Raw key edges of the scanned inputs that are not gesture buttons. The
+// key id is the input number in the chain, so inputs TOTAL_BTNS and up are
+// keys 3.., with no gestures: just press and release.
+typedef struct {
+	uint8_t key;
+	bool is_pressed;
+	uint32_t timestamp;           // Clock_now_us() of the scan that settled it
+} ScanKeys_event_t;
+
+// Packed for the ring: bits 0-6 key, 7 pressed, 8-31 the timestamp's low
+// 24 bits (16.7 s of us)
+#define SCAN_KEYS_PACKED_TIME_SHIFT 8
+#define SCAN_KEYS_PACKED_TIME_MASK  (0xFFFFFFFFUL >> SCAN_KEYS_PACKED_TIME_SHIFT)
+
+typedef struct {
+	uint32_t scans;
+	uint32_t edges;               // Put in the ring
+	uint32_t dropped;             // Found the ring full
+	uint32_t last_cycles;         // Debounce and queue cost of a scan
+	uint32_t max_cycles;
+} ScanKeys_stats_t;
+
+typedef struct {
+	uint32_t mask[INPUT_SCAN_WORDS];        // Inputs owned, the rest go to the button bank
+	Debounce_t debounce[INPUT_SCAN_WORDS];  // One vertical counter word per 32 inputs
+	EventRing_t *ring;
+	osThreadId_t consumer;        // Woken with consumer_flag after every put
+	uint32_t consumer_flag;
+	ScanKeys_stats_t stats;
+} ScanKeys_t;
+
+// Owns inputs first..inputs-1 of the chain. ring may be NULL for a bank
+// that is only read through ScanKeys_pressed.
+void ScanKeys_ctor(ScanKeys_t * const me, uint16_t first, uint16_t inputs, EventRing_t *ring);
+
+void ScanKeys_set_consumer(ScanKeys_t * const me, osThreadId_t thread, uint32_t flag);
+
+// One scan (InputScan words, 0 = pressed) taken at now (us): debounce every
+// owned input and queue the edges
+void ScanKeys_process(ScanKeys_t * const me, const uint32_t *words, uint32_t now);
+
+// Consumer side, never blocks; false when the ring is empty
+bool ScanKeys_receive(ScanKeys_t * const me, ScanKeys_event_t *event);
+
+// Debounced keys held down, bit n of word n / 32 is input n
+void ScanKeys_pressed(const ScanKeys_t * const me, uint32_t *words);
+
+// Time runs scans with every key released and log the cycles per scan
+void ScanKeys_benchmark(ScanKeys_t * const me, uint16_t runs);
+
+#endif /* SCANKEYS_H_ */
@@ -0,0 +1,36 @@
+/*
+ *  @file SettingsFlash.h
+ *
+ *  Created on: 29-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef SETTINGSFLASH_H_
+#define SETTINGSFLASH_H_
+
+#include "main.h"
+#include "SettingsStore.h"
+
+// Sectors 1 and 2, 16 KB each, one per SettingsStore bank. The linker
+// script keeps them out of FLASH; sector 0 holds only the vector table.
+#define SETTINGS_FLASH_SECTOR_0  FLASH_SECTOR_1
+#define SETTINGS_FLASH_SECTOR_1  FLASH_SECTOR_2
+#define SETTINGS_FLASH_ADDRESS_0 0x08004000UL
+#define SETTINGS_FLASH_ADDRESS_1 0x08008000UL
+#define SETTINGS_FLASH_SIZE      (16UL * 1024UL)
+
+// Internal flash backend for SettingsStore. The F411 has a single flash
+// bank, so instruction fetch stalls while a sector is erased or
+// programmed, and with it every interrupt whose handler runs from flash.
+// A 16 KB erase takes 250 ms typically and 500 ms at most (datasheet, x32
+// parallelism), once per 1024 records, from MenuLogicTask. During it the
+// kernel tick and the TIM5 interrupt are held off, so ticks are lost; the
+// TIM5 counter itself keeps counting, so Clock_now_us stays right. DMA
+// button sampling carries on into RAM, but its 64-sample ring covers only
+// 64 ms, so a press shorter than the stall can be overwritten before the
+// task reads it. The store erases the bank it is about to start, never
+// the one holding the latest settings, so a reset during the erase is
+// harmless.
+void SettingsFlash_ctor(SettingsStore_flash_t *flash);
+
+#endif /* SETTINGSFLASH_H_ */
@@ -0,0 +1,88 @@
+/*
+ *  @file SettingsStore.h
+ *
+ *  Created on: 29-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef SETTINGSSTORE_H_
+#define SETTINGSSTORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// No HAL includes: the store only reaches flash through
+// SettingsStore_flash_t, so it builds on a host against a simulated one
+
+#define SETTINGS_STORE_DATA_SIZE 8      // Payload bytes per record
+#define SETTINGS_STORE_IDLE_MS   2000   // Quiet time before a change is written
+#define SETTINGS_STORE_MAGIC     0x5E77U
+#define SETTINGS_STORE_NO_DEADLINE 0xFFFFFFFFUL  // Same value as osWaitForever
+#define SETTINGS_STORE_BANKS     2
+
+// Two flash banks (sectors) of the same size, each erased to 0xFF on its
+// own, programmed in 32-bit words and read through its memory mapping.
+// The log fills one bank, then starts the other with the latest settings,
+// so the bank being erased never holds the only copy.
+typedef struct {
+	const uint8_t *base[SETTINGS_STORE_BANKS];
+	uint32_t size;              // Bytes per bank, records past the last whole one are unused
+	bool (*erase)(void *ctx, uint8_t bank);
+	bool (*program)(void *ctx, uint8_t bank, uint32_t offset, const uint32_t *words, uint32_t count);
+	void *ctx;
+} SettingsStore_flash_t;
+
+// Appended one after another, the last valid one is the current settings.
+// The CRC is written last, so a record torn by a reset fails its check.
+typedef struct {
+	uint16_t magic;
+	uint16_t erases;                        // Bank switches so far, carried forward; the newer bank has the higher count
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint32_t crc;                           // CRC-32 of the fields above
+} SettingsStore_record_t;
+
+typedef struct {
+	uint32_t writes;            // Records appended since boot
+	uint32_t coalesced;         // Saves folded into a later write
+	uint32_t failures;          // Erase or program errors
+	uint16_t erases;            // Bank switches (one erase each) over the device's life
+	uint16_t probes;            // Records read at mount to find the latest, both banks
+	bool is_restored;           // Mount found a valid record
+} SettingsStore_stats_t;
+
+typedef struct {
+	const SettingsStore_flash_t *flash;
+	uint8_t bank;               // Bank being appended to
+	uint32_t next;              // Offset of the first free record in it
+	uint8_t current[SETTINGS_STORE_DATA_SIZE];  // Latest record in flash
+	uint8_t pending[SETTINGS_STORE_DATA_SIZE];  // Waiting for the idle time
+	bool is_pending;
+	bool is_changed;            // Saved since the last service
+	uint32_t changed_time;      // ms
+	SettingsStore_stats_t stats;
+} SettingsStore_t;
+
+// Mounts the log: in each bank a binary search for the first free record,
+// then only the latest record (or the few before it, if torn) is checked.
+// The bank whose latest record has the higher erase count is current.
+void SettingsStore_ctor(SettingsStore_t * const me, const SettingsStore_flash_t *flash);
+
+// Copies the restored settings, false if there are none (use defaults)
+bool SettingsStore_load(const SettingsStore_t * const me, uint8_t *data);
+
+// Cheap, never touches flash: the data waits until SettingsStore_service
+// has seen SETTINGS_STORE_IDLE_MS without another save
+void SettingsStore_save(SettingsStore_t * const me, const uint8_t *data);
+
+// Writes pending data once idle, returns true if a record was appended
+bool SettingsStore_service(SettingsStore_t * const me, uint32_t now);
+
+// Writes pending data now
+bool SettingsStore_flush(SettingsStore_t * const me);
+
+// ms until SettingsStore_service has work, SETTINGS_STORE_NO_DEADLINE if none
+uint32_t SettingsStore_next_deadline_ms(const SettingsStore_t * const me, uint32_t now);
+
+void SettingsStore_get_stats(const SettingsStore_t * const me, SettingsStore_stats_t *out);
+
+#endif /* SETTINGSSTORE_H_ */
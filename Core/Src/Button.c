@@ -1,104 +1,273 @@
 #include "Button.h"
-
-#define DEBOUNCE_MS 30
-#define SINGLE_WINDOW     (300)
-#define DOUBLE_WINDOW     (500)
-#define TRIPLE_WINDOW     (700)
-#define LONG_PRESS_TIME   (1500)
+#include "Gesture.h"
+#include "Clock.h"
 
 //static char *const tag = "Button";
 
 void Button_ctor(Button_t *const me, BTN_id_e id, GPIO_TypeDef *port,
-		uint16_t pin, osMessageQueueId_t queue_handler) {
+		uint32_t pin) {
 	me->id = id;
 	me->port = port;
 	me->pin = pin;
-	me->queue_handler = queue_handler;
-
-	GPIO_PinState init_state = HAL_GPIO_ReadPin(me->port, me->pin);
-	me->last_state = init_state;
-	me->last_raw_state = init_state;
-
-	me->last_time = HAL_GetTick();
-	me->debounce_time = HAL_GetTick();
-
-	me->click_count = 0;
-	me->is_long_press_sent = false;
-}
-
-void Button_read(Button_t *const me) {
-	uint32_t now = HAL_GetTick();
-	GPIO_PinState current_raw_state = HAL_GPIO_ReadPin(me->port, me->pin);
-
-	// --- DEBOUNCE ---
-	if (current_raw_state != me->last_raw_state) {
-		me->debounce_time = now; // Reset debounce timer on any flicker
-	}
-	me->last_raw_state = current_raw_state;
-
-	// Process the edge (after stability)
-	if ((now - me->debounce_time) > DEBOUNCE_MS) {
-		if (current_raw_state != me->last_state) {
-			// EDGE DETECTED
-			if (current_raw_state == GPIO_PIN_RESET) { // FALLING (Press -> Active Low)
-				if (me->click_count == 0)
-					me->first_click_time = now;
-				me->click_count++;
-				me->last_time = now; // Start "hold" timer
-				me->is_long_press_sent = false;
-			} else { // RISING (Release)
-				if (me->is_long_press_sent) {
-					me->click_count = 0; // It was a long press, reset count
-				}
-				me->last_time = now; // Start "idle" timer
-			}
-			me->last_state = current_raw_state;
+	me->edge_time = Clock_now_us();
+	me->burst_start_time = me->edge_time;
+	me->is_bouncing = false;
+	me->settle_time = me->edge_time;
+
+	me->bounce = (Button_bounce_stats_t ) { 0 };
+	me->bounce.debounce_ms = DEBOUNCE_MS;
+	me->bounce.learned_ms = DEBOUNCE_MS - DEBOUNCE_MARGIN_MS;
+}
+
+void Button_edge_from_isr(Button_t *const me, uint32_t now) {
+	if (!me->is_bouncing) {
+		me->burst_start_time = now;
+		me->is_bouncing = true;
+	}
+	me->edge_time = now;
+}
+
+void Button_get_bounce_stats(const Button_t *const me,
+		Button_bounce_stats_t *out) {
+	*out = me->bounce;
+}
+
+static uint32_t elapsed(uint32_t now, uint32_t since) {
+	// An edge stamped after now was read (ISR racing the task) is no time ago
+	int32_t diff = (int32_t) (now - since);
+	return (diff > 0) ? (uint32_t) diff : 0;
+}
+
+static uint16_t clamp_u16(uint32_t value, uint32_t lo, uint32_t hi) {
+	return (uint16_t) ((value < lo) ? lo : ((value > hi) ? hi : value));
+}
+
+// A bounce burst from first_edge to last_edge has just settled: record it
+// and adapt the window. Returns the new window in ms.
+static uint16_t button_learn(Button_t *const me, uint32_t first_edge,
+		uint32_t last_edge, uint32_t now) {
+	Button_bounce_stats_t *stats = &me->bounce;
+	uint32_t bounce = CLOCK_US_TO_MS(last_edge - first_edge);
+
+	stats->bursts++;
+	if (bounce > stats->max_ms) {
+		stats->max_ms = clamp_u16(bounce, 0, 0xFFFF);
+	}
+	uint32_t bucket = bounce / BUTTON_BOUNCE_BUCKET_MS;
+	stats->histogram[(bucket < BUTTON_BOUNCE_BUCKETS) ?
+			bucket : BUTTON_BOUNCE_BUCKETS - 1]++;
+
+	// A burst starting within one window of the previous settle is most
+	// likely the tail of that bounce, and the quiet stretch inside it lasted
+	// the whole window plus the gap: the window must outgrow that
+	uint32_t gap = elapsed(first_edge, me->settle_time);
+	if (stats->bursts > 1 && gap < CLOCK_MS_TO_US(stats->debounce_ms)) {
+		stats->late_bounces++;
+		uint32_t quiet = stats->debounce_ms + CLOCK_US_TO_MS(gap);
+		if (bounce < quiet) {
+			bounce = quiet;
 		}
 	}
 
-	// --- STATE DECISION ---
+	// Follow longer bounces at once, forget them over about eight edges
+	if (bounce >= stats->learned_ms) {
+		stats->learned_ms = clamp_u16(bounce, 0, DEBOUNCE_MAX_MS);
+	} else {
+		stats->learned_ms -= (stats->learned_ms - bounce + 7) / 8;
+	}
+	stats->debounce_ms = clamp_u16(stats->learned_ms + DEBOUNCE_MARGIN_MS,
+			DEBOUNCE_MIN_MS, DEBOUNCE_MAX_MS);
+
+	me->settle_time = now;
+	return stats->debounce_ms;
+}
+
+void Button_bank_ctor(Button_bank_t *const me, GPIO_TypeDef *port,
+		Button_t *buttons, uint8_t count, struct Gesture_s *gesture) {
+	me->port = port;
+	me->buttons = buttons;
+	me->count = count;
+	me->pin_mask = 0;
+	me->gesture = gesture;
+
+	for (int bit = 0; bit < BUTTON_BANK_PINS; bit++) {
+		me->bit_to_button[bit] = BUTTON_BANK_NONE;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		me->bit_to_button[__builtin_ctz(buttons[i].pin)] = i;
+		me->pin_mask |= buttons[i].pin;
+	}
+
+	// Scanned inputs start released, the first scans settle them
+	me->raw = (me->port != NULL) ? (me->port->IDR & me->pin_mask) : me->pin_mask;
+	me->bouncing = 0;
+	Debounce_ctor(&me->debounce, me->raw, DEBOUNCE_MS / BUTTON_SAMPLE_MS);
+}
+
+// Hand debounced edges to the gesture recognizer
+static void bank_edges(Button_bank_t *const me, uint32_t changed,
+		uint32_t edge_time, bool use_isr_time) {
+	while (changed) {
+		uint32_t bit = __builtin_ctz(changed);
+		changed &= changed - 1;
+
+		Button_t *btn = &me->buttons[me->bit_to_button[bit]];
+		bool is_pressed = !(me->debounce.state & (1U << bit)); // Active low
+		Gesture_edge(me->gesture, btn->id, is_pressed,
+				use_isr_time ? btn->edge_time : edge_time);
+	}
+}
+
+// DMA mode: stamp the raw edges in a sample, the first one opens a burst
+static void bank_track_raw(Button_bank_t *const me, uint32_t moved,
+		uint32_t sample_time) {
+	me->bouncing |= moved;
+	while (moved) {
+		uint32_t bit = __builtin_ctz(moved);
+		moved &= moved - 1;
+		Button_edge_from_isr(&me->buttons[me->bit_to_button[bit]], sample_time);
+	}
+}
+
+// DMA mode: close the bursts that either changed the level or went back to
+// it and stayed quiet for the button's window
+static void bank_track_settled(Button_bank_t *const me, uint32_t changed,
+		uint32_t sample, uint32_t sample_time) {
+	uint32_t settling = me->bouncing & ~(sample ^ me->debounce.state);
+	while (settling) {
+		uint32_t bit = __builtin_ctz(settling);
+		settling &= settling - 1;
 
-	// Check for Long Press (While held down)
-	if (me->last_state == GPIO_PIN_RESET && !me->is_long_press_sent) {
-		if ((now - me->last_time) > LONG_PRESS_TIME) {
-//			log_message(tag, LOG_INFO, "Long Press on BTN %d", me->id);
-			BTN_event_t event = {.id = me->id,.type = LONG_PRESS,.timestamp = now};
-			osMessageQueuePut(me->queue_handler, &event, 0U, 0U);
-			me->is_long_press_sent = true;
+		Button_t *btn = &me->buttons[me->bit_to_button[bit]];
+		if (!(changed & (1U << bit))
+				&& elapsed(sample_time, btn->edge_time)
+						< CLOCK_MS_TO_US(btn->bounce.debounce_ms)) {
+			continue;
 		}
+
+		btn->is_bouncing = false;
+		me->bouncing &= ~(1U << bit);
+		uint16_t window = button_learn(btn, btn->burst_start_time,
+				btn->edge_time, sample_time);
+		Debounce_set_limit(&me->debounce, 1U << bit,
+				window / BUTTON_SAMPLE_MS);
 	}
+}
 
-	// Check for Multi-Click Decisions (While released)
-	if (me->last_state == GPIO_PIN_SET && me->click_count > 0) {
-		uint32_t idle_time = now - me->last_time;
-		uint32_t total_time = now - me->first_click_time;
-		BTN_event_t event = {.id = me->id,.timestamp = now};
-		bool to_send = false;
+// Polled: one raw sample, already masked to the bank
+static void bank_sample(Button_bank_t *const me, uint32_t sample,
+		uint32_t sample_time) {
+	uint32_t moved = sample ^ me->raw;
+	if (moved) {
+		bank_track_raw(me, moved, sample_time);
+		me->raw = sample;
+	}
+
+	uint32_t changed = Debounce_update(&me->debounce, sample);
+	if (me->bouncing) {
+		bank_track_settled(me, changed, sample, sample_time);
+	}
+	if (changed) {
+		bank_edges(me, changed, sample_time, false);
+	}
+}
+
+void Button_bank_process(Button_bank_t *const me, const uint16_t *samples,
+		uint16_t count, uint32_t now) {
+	for (uint16_t i = 0; i < count; i++) {
+		// Date edges by their own sample, not by the batch
+		uint32_t sample_time = now
+				- (uint32_t) (count - 1 - i) * CLOCK_MS_TO_US(BUTTON_SAMPLE_MS);
+		bank_sample(me, samples[i] & me->pin_mask, sample_time);
+	}
 
-		// Triple Press (Immediate trigger on 3rd release)
-		if (me->click_count == 3) {
-//			log_message(tag, LOG_INFO, "Triple Press on BTN %d", me->id);
-			event.type = TRIPLE_PRESS;
-			to_send = true;
-			me->click_count = 0;
+	Gesture_tick(me->gesture, now);
+}
+
+void Button_bank_process_scan(Button_bank_t *const me, uint32_t sample,
+		uint32_t now) {
+	bank_sample(me, sample & me->pin_mask, now);
+	Gesture_tick(me->gesture, now);
+}
+
+void Button_bank_settled(Button_bank_t *const me) {
+	uint32_t now = Clock_now_us();
+	uint32_t quiet = 0;
+
+	for (uint8_t i = 0; i < me->count; i++) {
+		Button_t *btn = &me->buttons[i];
+
+		// Take the burst from under the interrupt in one piece
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		bool is_quiet = btn->is_bouncing
+				&& elapsed(now, btn->edge_time)
+						>= CLOCK_MS_TO_US(btn->bounce.debounce_ms);
+		uint32_t first_edge = btn->burst_start_time;
+		uint32_t last_edge = btn->edge_time;
+		if (is_quiet) {
+			btn->is_bouncing = false;
 		}
-		// Double Press (Trigger if 2 clicks exist and window for 3rd has closed)
-		else if (me->click_count == 2
-				&& (total_time > TRIPLE_WINDOW || idle_time > (DOUBLE_WINDOW - SINGLE_WINDOW))) {
-//			log_message(tag, LOG_INFO, "Double Press on BTN %d", me->id);
-			event.type = DOUBLE_PRESS;
-			to_send = true;
-			me->click_count = 0;
+		__set_PRIMASK(primask);
+
+		if (is_quiet) {
+			quiet |= btn->pin;
+			button_learn(btn, first_edge, last_edge, now);
 		}
-		// Single Press (Trigger if 1 click exists and window for 2nd has closed)
-		else if (me->click_count == 1
-				&& (total_time > DOUBLE_WINDOW || idle_time > SINGLE_WINDOW)) {
-//			log_message(tag, LOG_INFO, "Single Press on BTN %d", me->id);
-			event.type = SINGLE_PRESS;
-			to_send = true;
-			me->click_count = 0;
+	}
+
+	// Those pins have been quiet for their window, so their level is stable
+	uint32_t changed = Debounce_force(&me->debounce,
+			me->port->IDR & me->pin_mask, quiet);
+
+	// Date the edges by the interrupt, not by when the task got here
+	bank_edges(me, changed, now, true);
+	Gesture_tick(me->gesture, now);
+}
+
+void Button_bank_edge_from_isr(Button_bank_t *const me, uint16_t pin,
+		uint32_t now) {
+	uint16_t pins = pin & me->pin_mask;
+	while (pins) {
+		uint32_t bit = __builtin_ctz(pins);
+		pins &= pins - 1;
+		Button_edge_from_isr(&me->buttons[me->bit_to_button[bit]], now);
+	}
+}
+
+uint32_t Button_bank_settle_deadline_ms(Button_bank_t *const me,
+		uint32_t now) {
+	uint32_t deadline = osWaitForever;
+
+	for (uint8_t i = 0; i < me->count; i++) {
+		Button_t *btn = &me->buttons[i];
+		if (!btn->is_bouncing) {
+			continue;
 		}
+		uint32_t quiet = elapsed(now, btn->edge_time);
+		uint32_t window = CLOCK_MS_TO_US(btn->bounce.debounce_ms);
+		uint32_t left = (quiet < window) ? CLOCK_US_TO_MS(window - quiet) : 0;
+		if (left < deadline) {
+			deadline = left;
+		}
+	}
+
+	return deadline;
+}
 
-		if(to_send) osMessageQueuePut(me->queue_handler, &event, 0U, 20U);
+uint32_t Button_bank_next_deadline_ms(Button_bank_t *const me, uint32_t now) {
+	return Gesture_next_deadline_ms(me->gesture, now);
+}
+
+bool Button_bank_is_idle(const Button_bank_t *const me) {
+	if (me->bouncing != 0) {
+		return false;
+	}
+	for (uint8_t i = 0; i < me->count; i++) {
+		if (me->buttons[i].is_bouncing) {
+			return false;
+		}
 	}
+	// Active low: every pin high is every button released
+	return (me->debounce.state & me->pin_mask) == me->pin_mask;
 }
@@ -0,0 +1,55 @@
+/*
+ * Clock.c
+ *
+ *  Created on: 23-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "Clock.h"
+
+// Counter overflows so far, the upper half of the 64-bit time
+static volatile uint32_t overflows = 0;
+
+uint64_t Clock_now_us64(void) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t high = overflows;
+	uint32_t low = CLOCK_TIM->CNT;
+	// Wrapped but the interrupt has not run yet (we are masking it, or
+	// preempting it): re-read so the low half is past the wrap too
+	if (CLOCK_TIM->SR & TIM_SR_UIF) {
+		high++;
+		low = CLOCK_TIM->CNT;
+	}
+
+	__set_PRIMASK(primask);
+	return ((uint64_t) high << 32) | low;
+}
+
+void Clock_irq_handler(void) {
+	uint32_t status = CLOCK_TIM->SR;
+
+	if (status & TIM_SR_UIF) {
+		// Count and clear together, so a reader never sees the wrapped
+		// counter with neither the flag nor the new count
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		overflows++;
+		CLOCK_TIM->SR = ~TIM_SR_UIF;
+		__set_PRIMASK(primask);
+	}
+
+	if ((status & TIM_SR_CC1IF) && (CLOCK_TIM->DIER & TIM_DIER_CC1IE)) {
+		CLOCK_TIM->SR = ~TIM_SR_CC1IF;
+		// Schedule from the last compare, not from now, so a late interrupt
+		// does not stretch the tick
+		CLOCK_TIM->CCR1 += CLOCK_TICK_US;
+		HAL_IncTick();
+	}
+}
+
+void Clock_resume_tick(void) {
+	CLOCK_TIM->CCR1 = CLOCK_TIM->CNT + CLOCK_TICK_US;
+	CLOCK_TIM->SR = ~TIM_SR_CC1IF;
+}
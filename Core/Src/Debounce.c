@@ -0,0 +1,68 @@
+/*
+ * Debounce.c
+ *
+ *  Created on: 20-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "Debounce.h"
+
+void Debounce_ctor(Debounce_t *const me, uint32_t initial, uint32_t limit) {
+	for (int i = 0; i < DEBOUNCE_PLANES; i++) {
+		me->counter[i] = 0;
+	}
+	Debounce_set_limit(me, 0xFFFFFFFFU, limit);
+	me->state = initial;
+}
+
+void Debounce_set_limit(Debounce_t *const me, uint32_t mask, uint32_t limit) {
+	if (limit < 1) limit = 1;
+	if (limit > DEBOUNCE_MAX_LIMIT) limit = DEBOUNCE_MAX_LIMIT;
+
+	for (int i = 0; i < DEBOUNCE_PLANES; i++) {
+		if (limit & (1U << i)) {
+			me->limit[i] |= mask;
+		} else {
+			me->limit[i] &= ~mask;
+		}
+	}
+}
+
+uint32_t Debounce_update(Debounce_t *const me, uint32_t sample) {
+	// Inputs that currently read differently from their debounced level
+	uint32_t delta = sample ^ me->state;
+
+	// Ripple-carry increment of every counter at once. Counters of inputs
+	// that agree with their state are cleared, so any bounce restarts them.
+	uint32_t carry = delta;
+	for (int i = 0; i < DEBOUNCE_PLANES; i++) {
+		uint32_t next_carry = me->counter[i] & carry;
+		me->counter[i] = (me->counter[i] ^ carry) & delta;
+		carry = next_carry;
+	}
+
+	// Bit-parallel compare of each counter against its own limit
+	uint32_t reached = delta;
+	for (int i = 0; i < DEBOUNCE_PLANES; i++) {
+		reached &= ~(me->counter[i] ^ me->limit[i]);
+	}
+
+	// Accepted inputs flip state and start counting from zero again
+	uint32_t toggle = reached | carry;
+	for (int i = 0; i < DEBOUNCE_PLANES; i++) {
+		me->counter[i] &= ~toggle;
+	}
+	me->state ^= toggle;
+	return toggle;
+}
+
+uint32_t Debounce_force(Debounce_t *const me, uint32_t sample, uint32_t mask) {
+	uint32_t changed = (sample ^ me->state) & mask;
+
+	for (int i = 0; i < DEBOUNCE_PLANES; i++) {
+		me->counter[i] &= ~mask;
+	}
+	me->state = (me->state & ~mask) | (sample & mask);
+
+	return changed;
+}
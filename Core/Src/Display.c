@@ -5,8 +5,11 @@
  *      Author: Priyanshu Roy
  */
 
+#include <string.h>
+
 #include "Display.h"
 #include "debug_logger.h"
+#include "Clock.h"
 
 #define MAX_BRIGHTNESS 10
 #define MIN_BRIGHTNESS 0
@@ -14,24 +17,156 @@
 
 static char *const tag = "Display";
 
+static inline uint8_t latency_bucket(uint32_t latency_us) {
+	// 0 -> 0, 1 -> 1, 2..3 -> 2, 4..7 -> 3, ...
+	uint8_t bucket = 32U - __CLZ(latency_us);
+	if (bucket >= DISPLAY_LATENCY_BUCKETS) {
+		bucket = DISPLAY_LATENCY_BUCKETS - 1;
+	}
+	return bucket;
+}
+
+// Times are Clock_now_us() readings. Must be called with hardware_mutex held
+static void record_latency(Display_Manager_t *const me, uint32_t enqueue_time,
+		uint32_t dequeue_time, uint32_t latch_time) {
+	Display_latency_stats_t *stats = &me->latency;
+
+	uint32_t queue_us = dequeue_time - enqueue_time;
+	uint32_t service_us = latch_time - dequeue_time;
+	uint32_t total_us = queue_us + service_us;
+
+	stats->count++;
+	stats->last_us = total_us;
+	if (total_us > stats->max_us) {
+		stats->max_us = total_us;
+	}
+	if (queue_us > stats->queue_max_us) {
+		stats->queue_max_us = queue_us;
+	}
+	if (service_us > stats->service_max_us) {
+		stats->service_max_us = service_us;
+	}
+	stats->queue_total_us += queue_us;
+	stats->service_total_us += service_us;
+	stats->histogram[latency_bucket(total_us)]++;
+}
+
+static inline uint32_t ms_to_ticks(uint32_t ms) {
+	return (ms * osKernelGetTickFreq()) / 1000U;
+}
+
+// Must be called with hardware_mutex held. While idle the new pattern is
+// latched but the dimmed/blanked output level is kept; the brightness is
+// applied on wake.
+static void latch_frame(Display_Manager_t *const me, uint16_t data,
+		uint8_t brightness) {
+	if (me->idle_state == DISPLAY_ACTIVE) {
+		SN74HC595_update(me->shift_register, data, brightness);
+	} else {
+		SN74HC595_write(me->shift_register, data);
+	}
+
+	me->current_pattern = data;
+	me->current_brightness = brightness;
+}
+
+// Report a wake once its first frame is out. Call without hardware_mutex.
+static void log_wake(Display_Manager_t *const me) {
+	if (me->woke_from == DISPLAY_ACTIVE) {
+		return;
+	}
+	log_message(tag, LOG_INFO, "Woke from %s",
+			(me->woke_from == DISPLAY_BLANKED) ? "blank" : "dim");
+	me->woke_from = DISPLAY_ACTIVE;
+}
+
+void Display_channel_ctor(Display_channel_t *const channel,
+		osMessageQueueId_t queue, osMemoryPoolId_t pool) {
+	channel->queue = queue;
+	channel->pool = pool;
+	channel->high_water = 0;
+	channel->alloc_failures = 0;
+	channel->send_failures = 0;
+}
+
+Display_msg_t *Display_channel_alloc(Display_channel_t *const channel) {
+	Display_msg_t *msg = osMemoryPoolAlloc(channel->pool, 0U);
+	if (msg == NULL) {
+		channel->alloc_failures++;
+		return NULL;
+	}
+
+	// Producers may race here; the metric only ever errs low by one
+	uint32_t in_use = osMemoryPoolGetCount(channel->pool);
+	if (in_use > channel->high_water) {
+		channel->high_water = in_use;
+	}
+
+	return msg;
+}
+
+bool Display_channel_send(Display_channel_t *const channel, Display_msg_t *msg) {
+	// Only the pointer is copied into the queue
+	if (osMessageQueuePut(channel->queue, &msg, 0U, 0U) != osOK) {
+		channel->send_failures++;
+		osMemoryPoolFree(channel->pool, msg);
+		return false;
+	}
+
+	return true;
+}
+
+void Display_channel_free(Display_channel_t *const channel, Display_msg_t *msg) {
+	if (msg != NULL) {
+		osMemoryPoolFree(channel->pool, msg);
+	}
+}
+
 void Display_ctor(Display_Manager_t *const me, SN74HC595_t *shift_reg,
-		osMessageQueueId_t queue, osMutexId_t mutex) {
+		Display_channel_t *channel, osMutexId_t mutex) {
 
 	// Store references
 	me->shift_register = shift_reg;
-	me->update_queue = queue;
+	me->channel = channel;
 	me->hardware_mutex = mutex;
 
 	// Initialize state
 	me->current_pattern = 0x0000;
 	me->current_brightness = 5;  // Default medium brightness
 	me->is_enabled = true;
+	memset(&me->latency, 0, sizeof(me->latency));
+	memset(&me->throughput, 0, sizeof(me->throughput));
+
+	// Render on arrival until a frame rate is set
+	me->frame_rate_hz = 0;
+	me->frame_period_ticks = 0;
+	me->next_frame_tick = 0;
+	me->pending_msg = NULL;
+	me->is_pending_measured = false;
+	me->is_dirty = false;
+	me->batch_msg = NULL;
+	me->batch_index = 0;
+	me->batch_remaining_ms = 0;
+	me->is_batch_active = false;
+	memset(&me->frame_stats, 0, sizeof(me->frame_stats));
+
+	// Never dim until a timeout is set
+	me->idle_timeout_ms = 0;
+	me->dim_step_ms = 0;
+	me->last_activity_tick = osKernelGetTickCount();
+	me->next_dim_tick = 0;
+	me->dim_level = 0;
+	me->idle_state = DISPLAY_ACTIVE;
+	me->woke_from = DISPLAY_ACTIVE;
 
 	log_message(tag, LOG_INFO, "Display Manager initialized");
 }
 
 bool Display_update(Display_Manager_t *const me,
 		const Display_update_data_t *update) {
+	uint32_t dequeue_time = Clock_now_us();
+	uint32_t start_cycles = DWT->CYCCNT;
+
 	if (update == NULL) {
 		log_message(tag, LOG_ERROR, "Update data is NULL");
 		return false;
@@ -51,16 +186,19 @@ bool Display_update(Display_Manager_t *const me,
 		return false;
 	}
 
-	// Update shift register
-	SN74HC595_update(me->shift_register, update->data, update->brightness);
+	// Update shift register and local state
+	latch_frame(me, update->data, update->brightness);
+	record_latency(me, update->timestamp, dequeue_time,
+			me->shift_register->last_latch_time);
 
-	// Update local state
-	me->current_pattern = update->data;
-	me->current_brightness = update->brightness;
+	me->throughput.single.messages++;
+	me->throughput.single.frames++;
+	me->throughput.single.cycles += DWT->CYCCNT - start_cycles;
 
 	// Release mutex
 	osMutexRelease(me->hardware_mutex);
 
+	log_wake(me);
 	log_message(tag, LOG_DEBUG,
 			"Display updated: Pattern=0x%04X, Brightness=%d", update->data,
 			update->brightness);
@@ -68,6 +206,396 @@ bool Display_update(Display_Manager_t *const me,
 	return true;
 }
 
+bool Display_update_batch(Display_Manager_t *const me,
+		const Display_batch_t *batch) {
+	uint32_t dequeue_time = Clock_now_us();
+	uint32_t start_cycles = DWT->CYCCNT;
+	uint32_t wait_cycles = 0;
+
+	if (batch == NULL) {
+		log_message(tag, LOG_ERROR, "Batch data is NULL");
+		return false;
+	}
+
+	if (batch->count == 0 || batch->count > DISPLAY_BATCH_MAX_FRAMES) {
+		log_message(tag, LOG_ERROR, "Invalid batch size %d (max %d)",
+				batch->count, DISPLAY_BATCH_MAX_FRAMES);
+		return false;
+	}
+
+	// Frames back to back share one hardware acquisition; the mutex is
+	// released while a frame is held so other users are not locked out
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for batch (status: %d)",
+				status);
+		return false;
+	}
+
+	for (uint8_t i = 0; i < batch->count; i++) {
+		const Display_frame_t *frame = &batch->frames[i];
+
+		latch_frame(me, frame->data, frame->brightness);
+
+		// Latency is measured up to the first frame of the sequence
+		if (i == 0) {
+			record_latency(me, batch->timestamp, dequeue_time,
+					me->shift_register->last_latch_time);
+		}
+
+		// Hold the frame; the wait does not count as display work
+		if (frame->duration_ms > 0 && i + 1 < batch->count) {
+			osMutexRelease(me->hardware_mutex);
+			log_wake(me);
+			uint32_t wait_start = DWT->CYCCNT;
+			osDelay(frame->duration_ms);
+			wait_cycles += DWT->CYCCNT - wait_start;
+
+			status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+			if (status != osOK) {
+				log_message(tag, LOG_ERROR, "Batch stopped after %d of %d frames (status: %d)",
+						i + 1, batch->count, status);
+				return false;
+			}
+		}
+	}
+
+	me->throughput.batch.messages++;
+	me->throughput.batch.frames += batch->count;
+	me->throughput.batch.cycles += (DWT->CYCCNT - start_cycles) - wait_cycles;
+
+	// Release mutex
+	osMutexRelease(me->hardware_mutex);
+	log_wake(me);
+
+	// The last frame stays up until the next message, so its hold is
+	// waited out here, without the mutex
+	const Display_frame_t *last = &batch->frames[batch->count - 1];
+	if (last->duration_ms > 0) {
+		osDelay(last->duration_ms);
+	}
+
+	log_message(tag, LOG_DEBUG, "Batch of %d frames played, last Pattern=0x%04X",
+			batch->count, me->current_pattern);
+
+	return true;
+}
+
+bool Display_handle_message(Display_Manager_t *const me, Display_msg_t *msg) {
+	bool is_ok;
+
+	if (msg == NULL) {
+		log_message(tag, LOG_ERROR, "Message is NULL");
+		return false;
+	}
+
+	switch (msg->type) {
+	case DISPLAY_MSG_UPDATE:
+		is_ok = Display_update(me, &msg->update);
+		break;
+	case DISPLAY_MSG_BATCH:
+		is_ok = Display_update_batch(me, &msg->batch);
+		break;
+	case DISPLAY_MSG_ACTIVITY:
+		Display_notify_activity(me);
+		is_ok = true;
+		break;
+	default:
+		log_message(tag, LOG_ERROR, "Unknown message type %d", msg->type);
+		is_ok = false;
+		break;
+	}
+
+	// Frames are latched (or rejected): hand the block back to the pool
+	Display_channel_free(me->channel, msg);
+
+	return is_ok;
+}
+
+bool Display_set_frame_rate(Display_Manager_t *const me, uint16_t rate_hz) {
+	uint32_t tick_freq = osKernelGetTickFreq();
+
+	if (rate_hz != 0 && (rate_hz > tick_freq || (tick_freq % rate_hz) != 0)) {
+		log_message(tag, LOG_ERROR, "Frame rate %d Hz does not divide tick rate %lu Hz",
+				rate_hz, tick_freq);
+		return false;
+	}
+
+	me->frame_rate_hz = rate_hz;
+	me->frame_period_ticks = (rate_hz != 0) ? (tick_freq / rate_hz) : 0;
+	me->next_frame_tick = osKernelGetTickCount();
+	me->frame_stats.budget_cycles = (rate_hz != 0) ? (SystemCoreClock / rate_hz) : 0;
+
+	if (rate_hz == 0) {
+		log_message(tag, LOG_INFO, "Rendering on arrival");
+	} else {
+		log_message(tag, LOG_INFO, "Fixed-rate rendering at %d Hz", rate_hz);
+	}
+
+	return true;
+}
+
+uint16_t Display_get_frame_rate(Display_Manager_t *const me) {
+	return me->frame_rate_hz;
+}
+
+// Make a frame the next one to be latched by Display_render_frame. The
+// owner message, if any, is kept until the frame is latched or superseded.
+static void set_pending(Display_Manager_t *const me, uint16_t data,
+		uint8_t brightness, uint32_t timestamp, bool is_measured,
+		uint32_t dequeue_time, Display_msg_t *owner) {
+	if (me->is_dirty) {
+		me->frame_stats.coalesced++;
+	}
+	Display_channel_free(me->channel, me->pending_msg);
+
+	me->pending.data = data;
+	me->pending.brightness = brightness;
+	me->pending.timestamp = timestamp;
+	me->pending_msg = owner;
+	me->is_pending_measured = is_measured;
+	me->pending_dequeue_time = dequeue_time;
+	me->is_dirty = true;
+}
+
+// Move the active batch on by one frame period
+static void advance_batch(Display_Manager_t *const me) {
+	uint32_t period_ms = (me->frame_period_ticks * 1000U) / osKernelGetTickFreq();
+
+	if (me->batch_remaining_ms > period_ms) {
+		me->batch_remaining_ms -= period_ms;
+		return;
+	}
+
+	me->batch_index++;
+	if (me->batch_index >= me->batch_msg->batch.count) {
+		// Sequence finished, every frame of it has been latched
+		Display_channel_free(me->channel, me->batch_msg);
+		me->batch_msg = NULL;
+		me->is_batch_active = false;
+		return;
+	}
+
+	const Display_frame_t *frame = &me->batch_msg->batch.frames[me->batch_index];
+	set_pending(me, frame->data, frame->brightness, 0, false, Clock_now_us(), NULL);
+	me->batch_remaining_ms = frame->duration_ms;
+}
+
+// Pull queued messages into the pending frame; batches play to completion
+// before later messages are taken, as they would on arrival
+static void drain_queue(Display_Manager_t *const me) {
+	Display_msg_t *msg;
+
+	while (!me->is_batch_active
+			&& osMessageQueueGet(me->channel->queue, &msg, 0, 0) == osOK) {
+		uint32_t dequeue_time = Clock_now_us();
+
+		switch (msg->type) {
+		case DISPLAY_MSG_UPDATE:
+			set_pending(me, msg->update.data, msg->update.brightness,
+					msg->update.timestamp, true, dequeue_time, msg);
+			break;
+
+		case DISPLAY_MSG_BATCH:
+			if (msg->batch.count == 0 || msg->batch.count > DISPLAY_BATCH_MAX_FRAMES) {
+				log_message(tag, LOG_ERROR, "Invalid batch size %d (max %d)",
+						msg->batch.count, DISPLAY_BATCH_MAX_FRAMES);
+				Display_channel_free(me->channel, msg);
+				break;
+			}
+			set_pending(me, msg->batch.frames[0].data,
+					msg->batch.frames[0].brightness, msg->batch.timestamp, true,
+					dequeue_time, NULL);
+			me->batch_msg = msg;
+			me->batch_index = 0;
+			me->batch_remaining_ms = msg->batch.frames[0].duration_ms;
+			me->is_batch_active = true;
+			break;
+
+		case DISPLAY_MSG_ACTIVITY:
+			Display_notify_activity(me);
+			Display_channel_free(me->channel, msg);
+			break;
+
+		default:
+			log_message(tag, LOG_ERROR, "Unknown message type %d", msg->type);
+			Display_channel_free(me->channel, msg);
+			break;
+		}
+	}
+}
+
+void Display_render_frame(Display_Manager_t *const me) {
+	uint32_t start = DWT->CYCCNT;
+	bool is_rendered = false;
+
+	if (me->is_batch_active) {
+		advance_batch(me);
+	}
+	drain_queue(me);
+	Display_service_idle(me);
+
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for frame");
+		return;
+	}
+
+	// Only touch the hardware when something changed
+	if (me->is_dirty) {
+		latch_frame(me, me->pending.data, me->pending.brightness);
+		if (me->is_pending_measured) {
+			record_latency(me, me->pending.timestamp, me->pending_dequeue_time,
+					me->shift_register->last_latch_time);
+		}
+		Display_channel_free(me->channel, me->pending_msg);
+		me->pending_msg = NULL;
+		me->is_dirty = false;
+		is_rendered = true;
+	}
+
+	// Frame budget accounting
+	Display_frame_stats_t *stats = &me->frame_stats;
+	uint32_t cycles = DWT->CYCCNT - start;
+	stats->frames++;
+	if (is_rendered) {
+		stats->rendered++;
+	}
+	stats->last_cycles = cycles;
+	stats->total_cycles += cycles;
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+	if (cycles > stats->budget_cycles) {
+		stats->overruns++;
+	}
+
+	osMutexRelease(me->hardware_mutex);
+
+	if (is_rendered) {
+		log_wake(me);
+	}
+}
+
+void Display_wait_next_frame(Display_Manager_t *const me) {
+	me->next_frame_tick += me->frame_period_ticks;
+
+	if (osDelayUntil(me->next_frame_tick) != osOK) {
+		// Deadline already passed: drop the missed slots instead of bursting
+		uint32_t now = osKernelGetTickCount();
+		me->frame_stats.skipped += (now - me->next_frame_tick) / me->frame_period_ticks;
+		me->next_frame_tick = now;
+	}
+}
+
+void Display_set_idle_timeout(Display_Manager_t *const me,
+		uint32_t idle_timeout_ms, uint32_t dim_step_ms) {
+	me->idle_timeout_ms = idle_timeout_ms;
+	me->dim_step_ms = dim_step_ms;
+	me->last_activity_tick = osKernelGetTickCount();
+
+	if (idle_timeout_ms == 0) {
+		log_message(tag, LOG_INFO, "Inactivity dimming off");
+	} else {
+		log_message(tag, LOG_INFO, "Dimming after %lu ms idle, %lu ms per level",
+				idle_timeout_ms, dim_step_ms);
+	}
+}
+
+void Display_notify_activity(Display_Manager_t *const me) {
+	me->last_activity_tick = osKernelGetTickCount();
+
+	if (me->idle_state == DISPLAY_ACTIVE) {
+		return;
+	}
+
+	// Nothing is logged until the next frame is latched, so the wake is
+	// not held up by the UART
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for wake");
+		return;
+	}
+
+	// Restarting the timer is harmless while dimming, it is already running
+	SN74HC595_wake(me->shift_register, me->current_brightness);
+	me->is_enabled = true;
+	me->woke_from = me->idle_state;
+	me->idle_state = DISPLAY_ACTIVE;
+
+	osMutexRelease(me->hardware_mutex);
+}
+
+void Display_service_idle(Display_Manager_t *const me) {
+	if (me->idle_timeout_ms == 0 || me->idle_state == DISPLAY_BLANKED) {
+		return;
+	}
+
+	uint32_t now = osKernelGetTickCount();
+
+	if (me->idle_state == DISPLAY_ACTIVE) {
+		if ((now - me->last_activity_tick) < ms_to_ticks(me->idle_timeout_ms)) {
+			return;
+		}
+		me->idle_state = DISPLAY_DIMMING;
+		me->dim_level = me->current_brightness;
+		me->next_dim_tick = now;
+		log_message(tag, LOG_INFO, "Idle, dimming from %d", me->dim_level);
+	}
+
+	// One brightness level per step, then blank once at zero
+	while (me->idle_state == DISPLAY_DIMMING
+			&& (int32_t) (now - me->next_dim_tick) >= 0) {
+		if (me->dim_level == 0) {
+			Display_disable(me);
+
+			osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+			if (status != osOK) {
+				log_message(tag, LOG_ERROR, "Failed to acquire mutex for blank");
+				return;
+			}
+			SN74HC595_stop_pwm(me->shift_register);
+			me->idle_state = DISPLAY_BLANKED;
+			osMutexRelease(me->hardware_mutex);
+
+			log_message(tag, LOG_INFO, "Blanked, PWM stopped");
+			break;
+		}
+
+		osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+		if (status != osOK) {
+			log_message(tag, LOG_ERROR, "Failed to acquire mutex for dim");
+			return;
+		}
+		me->dim_level--;
+		SN74HC595_set_brightness(me->shift_register, me->dim_level);
+		osMutexRelease(me->hardware_mutex);
+
+		me->next_dim_tick += ms_to_ticks(me->dim_step_ms);
+	}
+}
+
+uint32_t Display_idle_wait_ticks(Display_Manager_t *const me) {
+	if (me->idle_timeout_ms == 0 || me->idle_state == DISPLAY_BLANKED) {
+		return osWaitForever;
+	}
+
+	uint32_t now = osKernelGetTickCount();
+	uint32_t deadline = (me->idle_state == DISPLAY_ACTIVE) ?
+			me->last_activity_tick + ms_to_ticks(me->idle_timeout_ms) :
+			me->next_dim_tick;
+
+	// Already due: poll without blocking
+	if ((int32_t) (deadline - now) <= 0) {
+		return 0;
+	}
+	return deadline - now;
+}
+
+Display_idle_state_e Display_get_idle_state(Display_Manager_t *const me) {
+	return me->idle_state;
+}
+
 bool Display_set_pattern(Display_Manager_t *const me, uint16_t pattern) {
 	// Acquire hardware mutex
 	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
@@ -183,3 +711,165 @@ void Display_get_state(Display_Manager_t *const me, uint16_t *pattern,
 bool Display_is_enabled(Display_Manager_t *const me) {
 	return me->is_enabled;
 }
+
+bool Display_get_latency_stats(Display_Manager_t *const me,
+		Display_latency_stats_t *stats) {
+	if (stats == NULL) {
+		return false;
+	}
+
+	// Take a consistent snapshot while the display task is not recording
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for stats");
+		return false;
+	}
+
+	*stats = me->latency;
+
+	osMutexRelease(me->hardware_mutex);
+
+	return true;
+}
+
+void Display_reset_latency_stats(Display_Manager_t *const me) {
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for stats reset");
+		return;
+	}
+
+	memset(&me->latency, 0, sizeof(me->latency));
+
+	osMutexRelease(me->hardware_mutex);
+}
+
+uint32_t Display_latency_percentile(const Display_latency_stats_t *stats,
+		uint8_t percentile) {
+	if (stats == NULL || stats->count == 0) {
+		return 0;
+	}
+	if (percentile > 100) {
+		percentile = 100;
+	}
+
+	// Rank of the requested sample, rounded up
+	uint32_t rank = (uint32_t) (((uint64_t) stats->count * percentile + 99U) / 100U);
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	uint32_t seen = 0;
+	for (uint8_t i = 0; i < DISPLAY_LATENCY_BUCKETS; i++) {
+		seen += stats->histogram[i];
+		if (seen >= rank) {
+			// Upper bound of the bucket, never above the observed maximum
+			uint32_t upper_us = (i == 0) ? 0 : ((1UL << i) - 1U);
+			if (i == DISPLAY_LATENCY_BUCKETS - 1 || upper_us > stats->max_us) {
+				upper_us = stats->max_us;
+			}
+			return upper_us;
+		}
+	}
+
+	return stats->max_us;
+}
+
+bool Display_get_throughput_stats(Display_Manager_t *const me,
+		Display_throughput_stats_t *stats) {
+	if (stats == NULL) {
+		return false;
+	}
+
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for stats");
+		return false;
+	}
+
+	*stats = me->throughput;
+
+	osMutexRelease(me->hardware_mutex);
+
+	return true;
+}
+
+uint32_t Display_frames_per_second(const Display_path_stats_t *path) {
+	if (path == NULL || path->cycles == 0) {
+		return 0;
+	}
+
+	// Frames the path could sustain if the CPU did nothing else
+	return (uint32_t) (((uint64_t) path->frames * SystemCoreClock) / path->cycles);
+}
+
+void Display_benchmark_submission(Display_Manager_t *const me, uint16_t frames) {
+	Display_path_stats_t single = { 0 };
+	Display_path_stats_t batch = { 0 };
+	uint16_t saved_pattern = me->current_pattern;
+	uint8_t brightness = me->current_brightness;
+
+	if (frames == 0) {
+		return;
+	}
+
+	// Per-frame submission: one hardware acquisition for every frame
+	for (uint16_t i = 0; i < frames; i++) {
+		uint32_t start = DWT->CYCCNT;
+		if (osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS) != osOK) {
+			log_message(tag, LOG_ERROR, "Failed to acquire mutex for benchmark");
+			return;
+		}
+		latch_frame(me, (uint16_t) (1U << (i % 16U)), brightness);
+		osMutexRelease(me->hardware_mutex);
+		single.cycles += DWT->CYCCNT - start;
+		single.messages++;
+		single.frames++;
+	}
+
+	// Batched: DISPLAY_BATCH_MAX_FRAMES frames with no hold per acquisition
+	for (uint16_t i = 0; i < frames; i += DISPLAY_BATCH_MAX_FRAMES) {
+		uint32_t start = DWT->CYCCNT;
+		if (osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS) != osOK) {
+			log_message(tag, LOG_ERROR, "Failed to acquire mutex for benchmark");
+			return;
+		}
+		for (uint16_t j = i; j < frames && j < i + DISPLAY_BATCH_MAX_FRAMES; j++) {
+			latch_frame(me, (uint16_t) (1U << (j % 16U)), brightness);
+			batch.frames++;
+		}
+		osMutexRelease(me->hardware_mutex);
+		batch.cycles += DWT->CYCCNT - start;
+		batch.messages++;
+	}
+
+	// Put back what was showing
+	if (osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS) == osOK) {
+		latch_frame(me, saved_pattern, brightness);
+		osMutexRelease(me->hardware_mutex);
+	}
+
+	log_message(tag, LOG_INFO, "%u frames: %lu cycles/frame one per message (%lu fps), %lu in batches of %d (%lu fps)",
+			frames, (uint32_t) (single.cycles / single.frames), Display_frames_per_second(&single),
+			(uint32_t) (batch.cycles / batch.frames), DISPLAY_BATCH_MAX_FRAMES,
+			Display_frames_per_second(&batch));
+}
+
+bool Display_get_frame_stats(Display_Manager_t *const me,
+		Display_frame_stats_t *stats) {
+	if (stats == NULL) {
+		return false;
+	}
+
+	osStatus_t status = osMutexAcquire(me->hardware_mutex, MUTEX_TIMEOUT_MS);
+	if (status != osOK) {
+		log_message(tag, LOG_ERROR, "Failed to acquire mutex for stats");
+		return false;
+	}
+
+	*stats = me->frame_stats;
+
+	osMutexRelease(me->hardware_mutex);
+
+	return true;
+}
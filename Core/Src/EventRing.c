@@ -0,0 +1,50 @@
+/*
+ * EventRing.c
+ *
+ *  Created on: 27-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "EventRing.h"
+
+bool EventRing_ctor(EventRing_t *const me, uint32_t *buffer, uint16_t size) {
+	if (size == 0 || size > 0x8000U || (size & (size - 1U)) != 0) {
+		return false;
+	}
+	me->buffer = buffer;
+	me->mask = size - 1U;
+	me->head = 0;
+	me->tail = 0;
+	return true;
+}
+
+bool EventRing_put(EventRing_t *const me, uint32_t word) {
+	uint16_t tail = me->tail;
+
+	if ((uint16_t) (tail - me->head) > me->mask) {
+		return false;
+	}
+	me->buffer[tail & me->mask] = word;
+	// The word must land before the consumer can see the new tail
+	Port_barrier();
+	me->tail = tail + 1U;
+	return true;
+}
+
+bool EventRing_get(EventRing_t *const me, uint32_t *word) {
+	uint16_t head = me->head;
+
+	if (head == me->tail) {
+		return false;
+	}
+	// Read the word only after seeing the tail that published it
+	Port_barrier();
+	*word = me->buffer[head & me->mask];
+	Port_barrier();
+	me->head = head + 1U;
+	return true;
+}
+
+uint16_t EventRing_count(const EventRing_t *const me) {
+	return (uint16_t) (me->tail - me->head);
+}
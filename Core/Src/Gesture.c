@@ -0,0 +1,717 @@
+/*
+ * Gesture.c
+ *
+ *  Created on: 22-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "Gesture.h"
+#include "debug_logger.h"
+#include <string.h>
+
+#if !defined(PORT_HOST)
+#include "FreeRTOS.h"
+
+static char *const tag = "Gesture";
+#endif
+
+#define TOKEN(buttons, is_hold) ((uint8_t) (((buttons) << 1) | ((is_hold) ? 1U : 0U)))
+#define NO_WINDOW UINT32_MAX
+
+
+static uint8_t new_state(Gesture_machine_t *const m) {
+	if (m->state_count >= GESTURE_MAX_STATES) {
+		return GESTURE_NONE;
+	}
+	uint8_t s = m->state_count++;
+	memset(m->next[s], GESTURE_NONE, sizeof(m->next[s]));
+	m->accept[s] = GESTURE_NONE;
+	m->has_next[s] = false;
+	m->beyond[s] = 0;
+	m->gap_ms[s] = 0;
+	m->window_ms[s] = 0;
+	return s;
+}
+
+static uint32_t event_bit(const Gesture_def_t *def) {
+	return BTN_EVENT_BIT(def->id, def->type);
+}
+
+static uint32_t window_of(const Gesture_def_t *def) {
+	return (def->window_ms != 0) ? def->window_ms : NO_WINDOW;
+}
+
+static bool compile(Gesture_t *const me) {
+	Gesture_machine_t *m = &me->machine;
+	m->state_count = 0;
+	new_state(m); // Root
+
+	// Build the trie, gestures sharing a prefix share its states
+	for (uint8_t d = 0; d < me->def_count; d++) {
+		const Gesture_def_t *def = &me->defs[d];
+		uint8_t s = 0;
+
+		for (uint8_t k = 0; k < def->length; k++) {
+			uint8_t token = TOKEN(def->strokes[k].buttons, def->strokes[k].is_hold);
+			if (m->next[s][token] == GESTURE_NONE) {
+				uint8_t n = new_state(m);
+				if (n == GESTURE_NONE) {
+					return false;
+				}
+				m->next[s][token] = n;
+				m->has_next[s] = true;
+			}
+			s = m->next[s][token];
+		}
+		if (m->accept[s] == GESTURE_NONE) {
+			m->accept[s] = d; // First definition wins
+		}
+	}
+
+	// How long a state waits for its next stroke: the timing of the nearest
+	// gesture reachable through each child. Children are numbered after their
+	// parent, so walking backwards sees every child first.
+	uint16_t reach_gap[GESTURE_MAX_STATES];
+	uint32_t reach_window[GESTURE_MAX_STATES];
+
+	for (int s = m->state_count - 1; s >= 0; s--) {
+		for (uint32_t t = 0; t < GESTURE_TOKENS; t++) {
+			uint8_t c = m->next[s][t];
+			if (c == GESTURE_NONE) {
+				continue;
+			}
+			if (reach_gap[c] > m->gap_ms[s]) m->gap_ms[s] = reach_gap[c];
+			if (reach_window[c] > m->window_ms[s]) m->window_ms[s] = reach_window[c];
+			m->beyond[s] |= m->beyond[c];
+			if (m->accept[c] != GESTURE_NONE) {
+				m->beyond[s] |= event_bit(&me->defs[m->accept[c]]);
+			}
+		}
+
+		if (m->accept[s] != GESTURE_NONE) {
+			reach_gap[s] = me->defs[m->accept[s]].gap_ms;
+			reach_window[s] = window_of(&me->defs[m->accept[s]]);
+		} else {
+			reach_gap[s] = m->gap_ms[s];
+			reach_window[s] = m->window_ms[s];
+		}
+	}
+	return true;
+}
+
+bool Gesture_ctor(Gesture_t *const me, const Gesture_def_t *defs,
+		uint8_t def_count, const Gesture_repeat_cfg_t *key_repeat_cfg,
+		EventRing_t *control_ring, EventRing_t *nav_ring) {
+	me->defs = defs;
+	me->def_count = def_count;
+
+	me->state = 0;
+	me->held = 0;
+	me->stroke = 0;
+	me->is_hold_sent = false;
+	me->is_split = false;
+	me->hold_fed = 0;
+	me->tap_count = 0;
+	memset(me->down_time, 0, sizeof(me->down_time));
+	me->first_press_time = 0;
+	me->stroke_time = 0;
+	me->press_time = 0;
+	me->release_time = 0;
+	me->repeat_def = GESTURE_NONE;
+	me->next_repeat_time = 0;
+	me->speculative_def = GESTURE_NONE;
+	me->key_repeat_cfg = key_repeat_cfg;
+	me->key_repeat_id = GESTURE_NONE;
+	me->key_repeat_interval = 0;
+	me->next_key_repeat_time = 0;
+	me->accepted_events = BTN_EVENTS_ALL;
+
+	memset(me->lanes, 0, sizeof(me->lanes));
+	me->lanes[GESTURE_LANE_CONTROL].ring = control_ring;
+	me->lanes[GESTURE_LANE_NAV].ring = nav_ring;
+	me->stash_seq = 0;
+	me->control_events = 0;
+	me->is_speculation_open = false;
+	me->consumer = NULL;
+	me->consumer_flag = 0;
+	me->owner = NULL;
+	me->owner_flag = 0;
+
+	return compile(me);
+}
+
+void Gesture_set_accepted(Gesture_t *const me, uint32_t events) {
+	uint32_t dropped = me->accepted_events & ~events;
+	me->accepted_events = events;
+
+	// A gesture may be waiting on one of the dropped events: have the input
+	// side tick now instead of when the press window closes
+	Port_thread_t owner = me->owner;
+	if (dropped != 0 && owner != NULL) {
+		Port_notify(owner, me->owner_flag);
+	}
+}
+
+void Gesture_set_control_events(Gesture_t *const me, uint32_t events) {
+	me->control_events = events;
+}
+
+void Gesture_set_consumer(Gesture_t *const me, Port_thread_t thread,
+		uint32_t flag) {
+	me->consumer_flag = flag;
+	me->consumer = thread;
+}
+
+void Gesture_set_owner(Gesture_t *const me, Port_thread_t thread,
+		uint32_t flag) {
+	me->owner_flag = flag;
+	me->owner = thread;
+}
+
+// True while a gesture longer than the current state is still worth waiting for
+static bool is_worth_waiting(Gesture_t *const me, uint8_t state) {
+	return (me->machine.beyond[state] & me->accepted_events) != 0;
+}
+
+// Microseconds from since to now, 0 if since is still ahead
+static uint32_t elapsed(uint32_t now, uint32_t since) {
+	int32_t diff = (int32_t) (now - since);
+	return (diff > 0) ? (uint32_t) diff : 0U;
+}
+
+// Put a lane's stashed events in its ring, oldest first across all
+// buttons. Returns true once the stash is empty.
+static bool flush_lane(Gesture_t *const me, Gesture_lane_t *lane) {
+	while (lane->stash_count > 0) {
+		Gesture_stash_t *oldest = NULL;
+		for (uint8_t b = 0; b < TOTAL_BTNS; b++) {
+			Gesture_stash_t *stash = &lane->stash[b];
+			if (stash->count > 0 && (oldest == NULL
+					|| (int32_t) (stash->seq[stash->head] - oldest->seq[oldest->head]) < 0)) {
+				oldest = stash;
+			}
+		}
+
+		if (!EventRing_put(lane->ring, BTN_event_pack(&oldest->events[oldest->head]))) {
+			return false;
+		}
+		oldest->head = (oldest->head + 1) % GESTURE_STASH_DEPTH;
+		oldest->count--;
+		lane->stash_count--;
+		lane->emit_stats.sent++;
+	}
+	return true;
+}
+
+static void stash_event(Gesture_t *const me, Gesture_lane_t *lane,
+		const BTN_event_t *event) {
+	Gesture_stash_t *stash = &lane->stash[event->id];
+
+	if (stash->count >= GESTURE_STASH_DEPTH) {
+		lane->emit_stats.dropped[event->type]++;
+		return;
+	}
+	uint8_t tail = (stash->head + stash->count) % GESTURE_STASH_DEPTH;
+	stash->events[tail] = *event;
+	stash->seq[tail] = me->stash_seq++;
+	stash->count++;
+	lane->stash_count++;
+	lane->emit_stats.stashed++;
+	if (lane->stash_count > lane->emit_stats.stash_high_water) {
+		lane->emit_stats.stash_high_water = lane->stash_count;
+	}
+}
+
+static bool is_any_stashed(const Gesture_t *const me) {
+	for (uint8_t l = 0; l < GESTURE_LANES; l++) {
+		if (me->lanes[l].stash_count > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void notify_consumer(const Gesture_t *const me) {
+	Port_thread_t consumer = me->consumer;
+	if (consumer != NULL) {
+		Port_notify(consumer, me->consumer_flag);
+	}
+}
+
+static void flush_stash(Gesture_t *const me) {
+	bool is_sent = false;
+	for (uint8_t l = 0; l < GESTURE_LANES; l++) {
+		Gesture_lane_t *lane = &me->lanes[l];
+		if (lane->stash_count > 0) {
+			uint8_t before = lane->stash_count;
+			flush_lane(me, lane);
+			is_sent |= (lane->stash_count != before);
+		}
+	}
+	if (is_sent) {
+		notify_consumer(me);
+	}
+}
+
+// Speculative events and their confirmation or rollback must stay in one
+// ring to keep their order, so only a settled gesture outside an open
+// speculation may take the control lane
+static Gesture_lane_t *classify(Gesture_t *const me, BTN_id_e id,
+		BTN_event_e type, bool is_speculative) {
+	if (me->lanes[GESTURE_LANE_CONTROL].ring != NULL && !is_speculative
+			&& !me->is_speculation_open
+			&& (me->control_events & BTN_EVENT_BIT(id, type))) {
+		return &me->lanes[GESTURE_LANE_CONTROL];
+	}
+	return &me->lanes[GESTURE_LANE_NAV];
+}
+
+// Never blocks: a full ring parks the event in its button's stash, retried
+// from Gesture_tick, so the consumer can never stall input sampling
+static void send(Gesture_t *const me, BTN_id_e id, BTN_event_e type,
+		uint32_t now, bool is_speculative) {
+	BTN_event_t event = {.id = id,.type = type,.timestamp = now,
+			.is_speculative = is_speculative};
+	Gesture_lane_t *lane = classify(me, id, type, is_speculative);
+
+	// The next event after a speculative one confirms or replaces it
+	me->is_speculation_open = is_speculative;
+
+	// Stashed events go first, a new one must not overtake them
+	if (flush_lane(me, lane)
+			&& EventRing_put(lane->ring, BTN_event_pack(&event))) {
+		lane->emit_stats.sent++;
+		notify_consumer(me);
+		return;
+	}
+	stash_event(me, lane, &event);
+}
+
+static void emit(Gesture_t *const me, uint8_t def_index, uint32_t now,
+		bool is_speculative) {
+	const Gesture_def_t *def = &me->defs[def_index];
+	send(me, def->id, def->type, now, is_speculative);
+}
+
+// Report whatever the strokes so far amount to and return to the root. A
+// state without a gesture of its own settles on the last speculative one.
+static void commit(Gesture_t *const me, uint32_t now) {
+	uint8_t d = me->machine.accept[me->state];
+	if (d == GESTURE_NONE) {
+		d = me->speculative_def;
+	}
+	if (d != GESTURE_NONE) {
+		emit(me, d, now, false);
+	}
+	me->state = 0;
+	me->speculative_def = GESTURE_NONE;
+}
+
+static void feed(Gesture_t *const me, uint8_t token, uint32_t now,
+		bool is_hold) {
+	Gesture_machine_t *m = &me->machine;
+	uint8_t next = m->next[me->state][token];
+
+	if (next == GESTURE_NONE && me->state != 0) {
+		// The stroke does not extend the pending gesture: settle that one and
+		// let the stroke start a new gesture
+		commit(me, now);
+		me->first_press_time = me->stroke_time;
+		next = m->next[0][token];
+	}
+	if (next == GESTURE_NONE) {
+		me->state = 0; // Not part of any gesture
+		return;
+	}
+
+	me->state = next;
+	if (is_worth_waiting(me, next)) {
+		// Wait for a longer gesture, but let the consumer act on this one now.
+		// The final report either repeats it (confirm) or replaces it.
+		if (m->accept[next] != GESTURE_NONE) {
+			me->speculative_def = m->accept[next];
+			emit(me, me->speculative_def, now, true);
+		}
+		return;
+	}
+
+	// Nothing wanted can follow, report it right away
+	uint8_t d = m->accept[next];
+	if (d == GESTURE_NONE) {
+		d = me->speculative_def;
+	}
+	me->state = 0;
+	me->speculative_def = GESTURE_NONE;
+	if (d == GESTURE_NONE) {
+		return;
+	}
+	emit(me, d, now, false);
+	if (is_hold && me->defs[d].repeat_ms != 0) {
+		me->repeat_def = d;
+		me->next_repeat_time = now + CLOCK_MS_TO_US(me->defs[d].repeat_ms);
+	}
+}
+
+// A single button held on its own, with REPEAT wanted for it
+static bool can_start_key_repeat(Gesture_t *const me) {
+	if (me->key_repeat_cfg == NULL || me->key_repeat_id != GESTURE_NONE
+			|| me->is_hold_sent) {
+		return false;
+	}
+	if (me->stroke != me->held || (me->stroke & (me->stroke - 1)) != 0) {
+		return false;
+	}
+	BTN_id_e id = (BTN_id_e) __builtin_ctz(me->stroke);
+	return (me->accepted_events & BTN_EVENT_BIT(id, REPEAT)) != 0;
+}
+
+static void key_repeat(Gesture_t *const me, uint32_t now) {
+	const Gesture_repeat_cfg_t *cfg = me->key_repeat_cfg;
+
+	if (can_start_key_repeat(me)
+			&& elapsed(now, me->press_time) >= CLOCK_MS_TO_US(cfg->delay_ms)) {
+		if (me->state != 0) {
+			commit(me, now); // Settle earlier strokes first
+		}
+		// The stroke is spent: releasing it is neither a tap nor a hold
+		me->is_hold_sent = true;
+		me->key_repeat_id = (uint8_t) __builtin_ctz(me->stroke);
+		me->key_repeat_interval = cfg->start_ms;
+		me->next_key_repeat_time = now + CLOCK_MS_TO_US(cfg->start_ms);
+		send(me, (BTN_id_e) me->key_repeat_id, REPEAT, now, false);
+		return;
+	}
+
+	if (me->key_repeat_id != GESTURE_NONE
+			&& (int32_t) (now - me->next_key_repeat_time) >= 0) {
+		send(me, (BTN_id_e) me->key_repeat_id, REPEAT, now, false);
+		// Accelerate towards min_ms
+		uint32_t interval = (uint32_t) me->key_repeat_interval * cfg->step_percent / 100U;
+		me->key_repeat_interval = (interval > cfg->min_ms) ? (uint16_t) interval : cfg->min_ms;
+		me->next_key_repeat_time += CLOCK_MS_TO_US(me->key_repeat_interval);
+	}
+}
+
+// True if the stroke token leads to an event the consumer acts on, now or
+// after more strokes
+static bool is_stroke_wanted(Gesture_t *const me, uint8_t token) {
+	Gesture_machine_t *m = &me->machine;
+	uint8_t next = m->next[me->state][token];
+
+	if (next == GESTURE_NONE) {
+		next = m->next[0][token];
+	}
+	if (next == GESTURE_NONE) {
+		return false;
+	}
+	uint8_t d = m->accept[next];
+	return (d != GESTURE_NONE && (me->accepted_events & event_bit(&me->defs[d])))
+			|| is_worth_waiting(me, next);
+}
+
+// Holds are timed per button once the stroke is split, or while it spans
+// several buttons and no accepted chord hold matches them
+static bool is_hold_split(Gesture_t *const me) {
+	if (me->is_split) {
+		return true;
+	}
+	return (me->stroke & (me->stroke - 1)) != 0
+			&& !is_stroke_wanted(me, TOKEN(me->stroke, true));
+}
+
+// Keep the taps of a stroke in press order, the order they were meant in
+static void record_tap(Gesture_t *const me, BTN_id_e id) {
+	uint32_t down = me->down_time[id];
+	uint8_t i = me->tap_count;
+
+	if (i >= GESTURE_SPLIT_TAPS) {
+		return;
+	}
+	while (i > 0 && (int32_t) (me->tap_times[i - 1] - down) > 0) {
+		me->taps[i] = me->taps[i - 1];
+		me->tap_times[i] = me->tap_times[i - 1];
+		i--;
+	}
+	me->taps[i] = (uint8_t) id;
+	me->tap_times[i] = down;
+	me->tap_count++;
+}
+
+// Feed the recorded taps one button at a time
+static void feed_taps(Gesture_t *const me, uint32_t now) {
+	for (uint8_t i = 0; i < me->tap_count; i++) {
+		me->stroke_time = me->tap_times[i];
+		if (me->state == 0) {
+			me->first_press_time = me->stroke_time;
+		}
+		feed(me, TOKEN(BTN_MASK(me->taps[i]), false), now, false);
+	}
+	me->tap_count = 0;
+}
+
+// Split stroke: each button held past GESTURE_HOLD_MS since its own press
+// is fed as a hold of that button, after the taps that came before it
+static void feed_split_holds(Gesture_t *const me, uint32_t now) {
+	for (uint8_t b = 0; b < TOTAL_BTNS; b++) {
+		uint8_t bit = BTN_MASK(b);
+		if (!(me->held & bit) || (me->hold_fed & bit)
+				|| elapsed(now, me->down_time[b]) <= CLOCK_MS_TO_US(GESTURE_HOLD_MS)) {
+			continue;
+		}
+		me->is_split = true;
+		me->hold_fed |= bit;
+		feed_taps(me, now);
+		me->stroke_time = me->down_time[b];
+		if (me->state == 0) {
+			me->first_press_time = me->stroke_time;
+		}
+		feed(me, TOKEN(bit, true), now, false);
+	}
+}
+
+void Gesture_edge(Gesture_t *const me, BTN_id_e id, bool is_pressed,
+		uint32_t edge_time) {
+	uint8_t bit = BTN_MASK(id);
+
+	// Settle anything that ran out before this edge happened
+	Gesture_tick(me, edge_time);
+
+	if (is_pressed) {
+		if (me->held == 0) { // New stroke
+			me->stroke = 0;
+			me->is_hold_sent = false;
+			me->is_split = false;
+			me->hold_fed = 0;
+			me->tap_count = 0;
+			me->stroke_time = edge_time;
+			if (me->state == 0) {
+				me->first_press_time = edge_time;
+			}
+		} else if (me->is_hold_sent) {
+			// The buttons already down were spent on a hold or a repeat, the
+			// new one reports on its own
+			me->is_hold_sent = false;
+			me->is_split = true;
+			me->hold_fed = me->held;
+			me->repeat_def = GESTURE_NONE;
+		}
+		me->held |= bit;
+		me->stroke |= bit;
+		me->down_time[id] = edge_time;
+		me->key_repeat_id = GESTURE_NONE; // A second button ends the repeat
+		me->press_time = edge_time; // Hold counts from the last button joining
+	} else {
+		if (!(me->held & bit)) {
+			return; // Was already down before the recognizer started
+		}
+		me->held &= ~bit;
+		if (!me->is_hold_sent && !(me->hold_fed & bit)) {
+			record_tap(me, id);
+		}
+		me->hold_fed &= ~bit;
+		if (me->held == 0) { // Stroke complete
+			me->release_time = edge_time;
+			me->repeat_def = GESTURE_NONE;
+			me->key_repeat_id = GESTURE_NONE;
+			if (me->is_hold_sent) {
+				return;
+			}
+			bool is_single = (me->stroke & (me->stroke - 1)) == 0;
+			if (!me->is_split && (is_single
+					|| is_stroke_wanted(me, TOKEN(me->stroke, false)))) {
+				me->tap_count = 0;
+				feed(me, TOKEN(me->stroke, false), edge_time, false);
+			} else {
+				// No chord for these buttons: a rolling press, report each one
+				feed_taps(me, edge_time);
+			}
+		}
+	}
+}
+
+void Gesture_tick(Gesture_t *const me, uint32_t now) {
+	Gesture_machine_t *m = &me->machine;
+
+	if (is_any_stashed(me)) {
+		flush_stash(me);
+	}
+
+	if (me->held) {
+		key_repeat(me, now);
+		if (!me->is_hold_sent && is_hold_split(me)) {
+			feed_split_holds(me, now);
+		} else if (!me->is_hold_sent
+				&& elapsed(now, me->press_time) > CLOCK_MS_TO_US(GESTURE_HOLD_MS)) {
+			me->is_hold_sent = true;
+			feed(me, TOKEN(me->stroke, true), now, true);
+		}
+		if (me->repeat_def != GESTURE_NONE
+				&& (int32_t) (now - me->next_repeat_time) >= 0) {
+			emit(me, me->repeat_def, now, false);
+			me->next_repeat_time += CLOCK_MS_TO_US(me->defs[me->repeat_def].repeat_ms);
+		}
+		return;
+	}
+
+	// Released part-way through a gesture: stop waiting once either the
+	// pause or the whole gesture runs too long
+	if (me->state != 0) {
+		bool is_gap_over = elapsed(now, me->release_time)
+				> CLOCK_MS_TO_US(m->gap_ms[me->state]);
+		bool is_window_over = m->window_ms[me->state] != NO_WINDOW
+				&& elapsed(now, me->first_press_time)
+						> CLOCK_MS_TO_US(m->window_ms[me->state]);
+		// The consumer may have stopped caring about longer gestures
+		if (is_gap_over || is_window_over || !is_worth_waiting(me, me->state)) {
+			commit(me, now);
+		}
+	}
+}
+
+// Microseconds from now until end (0 if it has passed)
+static uint32_t time_until(uint32_t now, uint32_t end) {
+	int32_t remaining = (int32_t) (end - now);
+	return (remaining > 0) ? (uint32_t) remaining : 0U;
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b) {
+	return (a < b) ? a : b;
+}
+
+static uint32_t next_deadline_us(Gesture_t *const me, uint32_t now) {
+	Gesture_machine_t *m = &me->machine;
+	uint32_t next = PORT_WAIT_FOREVER;
+
+	if (me->held) {
+		if (!me->is_hold_sent && is_hold_split(me)) {
+			for (uint8_t b = 0; b < TOTAL_BTNS; b++) {
+				if ((me->held & ~me->hold_fed) & BTN_MASK(b)) {
+					next = min_u32(next, time_until(now,
+							me->down_time[b] + CLOCK_MS_TO_US(GESTURE_HOLD_MS) + 1));
+				}
+			}
+		} else if (!me->is_hold_sent) {
+			next = time_until(now,
+					me->press_time + CLOCK_MS_TO_US(GESTURE_HOLD_MS) + 1);
+		}
+		if (me->repeat_def != GESTURE_NONE) {
+			next = min_u32(next, time_until(now, me->next_repeat_time));
+		}
+		if (can_start_key_repeat(me)) {
+			next = min_u32(next, time_until(now,
+					me->press_time + CLOCK_MS_TO_US(me->key_repeat_cfg->delay_ms)));
+		}
+		if (me->key_repeat_id != GESTURE_NONE) {
+			next = min_u32(next, time_until(now, me->next_key_repeat_time));
+		}
+		return next;
+	}
+
+	if (me->state != 0) {
+		if (!is_worth_waiting(me, me->state)) {
+			return 0;
+		}
+		next = time_until(now,
+				me->release_time + CLOCK_MS_TO_US(m->gap_ms[me->state]) + 1);
+		if (m->window_ms[me->state] != NO_WINDOW) {
+			next = min_u32(next, time_until(now,
+					me->first_press_time + CLOCK_MS_TO_US(m->window_ms[me->state]) + 1));
+		}
+	}
+	return next;
+}
+
+uint32_t Gesture_next_deadline_ms(Gesture_t *const me, uint32_t now) {
+	uint32_t next = next_deadline_us(me, now);
+	next = (next == PORT_WAIT_FOREVER) ? PORT_WAIT_FOREVER : CLOCK_US_TO_MS(next);
+
+	// Keep retrying while events wait for room in the ring
+	if (is_any_stashed(me)) {
+		next = min_u32(next, GESTURE_STASH_RETRY_MS);
+	}
+	return next;
+}
+
+bool Gesture_receive(Gesture_t *const me, BTN_event_t *event) {
+	for (uint8_t l = 0; l < GESTURE_LANES; l++) {
+		Gesture_lane_t *lane = &me->lanes[l];
+		uint32_t packed;
+		if (lane->ring == NULL || !EventRing_get(lane->ring, &packed)) {
+			continue;
+		}
+
+		uint32_t now = Port_now_us();
+		BTN_event_unpack(packed, now, event);
+		Gesture_latency_stats_t *latency = &lane->latency;
+		uint32_t waited = now - event->timestamp;
+		latency->count++;
+		latency->last_us = waited;
+		latency->total_us += waited;
+		if (waited > latency->max_us) {
+			latency->max_us = waited;
+		}
+		return true;
+	}
+	return false;
+}
+
+void Gesture_get_emit_stats(const Gesture_t *const me, Gesture_lane_e lane,
+		Gesture_emit_stats_t *out) {
+	*out = me->lanes[lane].emit_stats;
+}
+
+void Gesture_get_latency_stats(const Gesture_t *const me, Gesture_lane_e lane,
+		Gesture_latency_stats_t *out) {
+	*out = me->lanes[lane].latency;
+}
+
+#if !defined(PORT_HOST)
+void Gesture_benchmark_delivery(uint16_t runs) {
+	BTN_event_t event = {.id = BTN_2,.type = DOUBLE_PRESS,
+			.timestamp = Port_now_us(),.is_speculative = false};
+	BTN_event_t received;
+	uint32_t packed;
+	uint32_t ring_buffer[1];
+	EventRing_t ring;
+	volatile uint32_t sink = 0; // Keeps the received events alive
+
+	// Statically allocated like the rest of the event path, no heap
+	static StaticQueue_t queue_cb;
+	static uint8_t queue_mem[sizeof(BTN_event_t)];
+	const osMessageQueueAttr_t queue_attributes = {
+		.name = "btn_bench_queue",
+		.cb_mem = &queue_cb,
+		.cb_size = sizeof(queue_cb),
+		.mq_mem = queue_mem,
+		.mq_size = sizeof(queue_mem),
+	};
+
+	osMessageQueueId_t queue = osMessageQueueNew(1, sizeof(BTN_event_t), &queue_attributes);
+	if (runs == 0 || queue == NULL) {
+		return;
+	}
+
+	uint32_t start = DWT->CYCCNT;
+	for (uint16_t i = 0; i < runs; i++) {
+		osMessageQueuePut(queue, &event, 0U, 0U);
+		osMessageQueueGet(queue, &received, NULL, 0U);
+		sink += received.timestamp;
+	}
+	uint32_t queue_cycles = (DWT->CYCCNT - start) / runs;
+	osMessageQueueDelete(queue);
+
+	EventRing_ctor(&ring, ring_buffer, 1);
+	start = DWT->CYCCNT;
+	for (uint16_t i = 0; i < runs; i++) {
+		EventRing_put(&ring, BTN_event_pack(&event));
+		EventRing_get(&ring, &packed);
+		BTN_event_unpack(packed, event.timestamp, &received);
+		sink += received.timestamp;
+	}
+	uint32_t ring_cycles = (DWT->CYCCNT - start) / runs;
+
+	log_message(tag, LOG_INFO,
+			"Event delivery: queue %lu cycles/event (%u bytes), packed ring %lu cycles/event (4 bytes)",
+			queue_cycles, (unsigned) sizeof(BTN_event_t), ring_cycles);
+}
+#endif
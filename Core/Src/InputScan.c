@@ -0,0 +1,58 @@
+/*
+ * InputScan.c
+ *
+ *  Created on: 24-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "InputScan.h"
+#include "debug_logger.h"
+
+static char *const tag = "InputScan";
+
+void InputScan_ctor(InputScan_t *const me, const char *name,
+		InputScan_read_fn read, void *ctx, uint16_t inputs) {
+	me->name = name;
+	me->read = read;
+	me->ctx = ctx;
+	me->inputs = (inputs < INPUT_SCAN_MAX_INPUTS) ? inputs : INPUT_SCAN_MAX_INPUTS;
+	me->stats = (InputScan_stats_t ) { 0 };
+}
+
+void InputScan_read(InputScan_t *const me, uint32_t *words) {
+	uint32_t start = DWT->CYCCNT;
+	me->read(me->ctx, words);
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	InputScan_stats_t *stats = &me->stats;
+	stats->scans++;
+	stats->last_cycles = cycles;
+	stats->total_cycles += cycles;
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+}
+
+void InputScan_benchmark(InputScan_t *const me, uint16_t runs) {
+	uint32_t words[INPUT_SCAN_WORDS];
+	InputScan_stats_t saved = me->stats;
+
+	if (runs == 0 || me->inputs == 0) {
+		return;
+	}
+
+	me->stats = (InputScan_stats_t ) { 0 };
+	for (uint16_t i = 0; i < runs; i++) {
+		InputScan_read(me, words);
+	}
+	uint32_t average = (uint32_t) (me->stats.total_cycles / runs);
+
+	log_message(tag, LOG_INFO,
+			"%s: %u inputs, %lu cycles/scan (%lu us), %lu cycles/input, max %lu",
+			me->name, me->inputs, average,
+			average / (SystemCoreClock / 1000000U), average / me->inputs,
+			me->stats.max_cycles);
+
+	// Benchmark scans are not part of the running statistics
+	me->stats = saved;
+}
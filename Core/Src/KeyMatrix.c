@@ -0,0 +1,75 @@
+/*
+ * KeyMatrix.c
+ *
+ *  Created on: 24-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "KeyMatrix.h"
+#include "debug_logger.h"
+
+static char *const tag = "KeyMatrix";
+
+void KeyMatrix_ctor(KeyMatrix_t *const me, const KeyMatrix_pin_t *rows,
+		uint8_t row_count, GPIO_TypeDef *col_port, uint8_t col_first,
+		uint8_t col_count, uint16_t settle_cycles) {
+	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+
+	me->rows = rows;
+	me->row_count = (row_count < KEYMATRIX_MAX_ROWS) ? row_count : KEYMATRIX_MAX_ROWS;
+	me->col_port = col_port;
+	me->col_first = col_first;
+	me->col_count = (col_count < KEYMATRIX_MAX_COLS) ? col_count : KEYMATRIX_MAX_COLS;
+	me->settle_cycles = settle_cycles;
+
+	// Rows idle released (open drain high = floating)
+	for (uint8_t r = 0; r < me->row_count; r++) {
+		HAL_GPIO_WritePin(rows[r].port, rows[r].pin, GPIO_PIN_SET);
+		GPIO_InitStruct.Pin = rows[r].pin;
+		GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+		HAL_GPIO_Init(rows[r].port, &GPIO_InitStruct);
+	}
+
+	GPIO_InitStruct.Pin = ((1U << me->col_count) - 1U) << me->col_first;
+	GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	HAL_GPIO_Init(me->col_port, &GPIO_InitStruct);
+
+	log_message(tag, LOG_INFO, "Key matrix initialized - %dx%d, %d inputs",
+			me->row_count, me->col_count, me->row_count * me->col_count);
+}
+
+void KeyMatrix_scan(void *ctx, uint32_t *words) {
+	KeyMatrix_t *const me = ctx;
+	uint32_t col_mask = (1U << me->col_count) - 1U;
+
+	for (int w = 0; w < INPUT_SCAN_WORDS; w++) {
+		words[w] = 0xFFFFFFFFU; // Missing inputs read as released
+	}
+
+	uint32_t input = 0;
+	for (uint8_t r = 0; r < me->row_count; r++) {
+		const KeyMatrix_pin_t *row = &me->rows[r];
+
+		HAL_GPIO_WritePin(row->port, row->pin, GPIO_PIN_RESET);
+		uint32_t start = DWT->CYCCNT;
+		while ((DWT->CYCCNT - start) < me->settle_cycles) {
+		}
+		// A pressed key pulls its column low, already the 0 = pressed polarity
+		uint32_t cols = (me->col_port->IDR >> me->col_first) & col_mask;
+		HAL_GPIO_WritePin(row->port, row->pin, GPIO_PIN_SET);
+
+		// Rows of up to 8 columns never straddle more than two words
+		uint32_t word = input / 32;
+		uint32_t shift = input % 32;
+		words[word] &= ~(col_mask << shift) | (cols << shift);
+		if (shift + me->col_count > 32) {
+			uint32_t spill = 32 - shift;
+			words[word + 1] &= ~(col_mask >> spill) | (cols >> spill);
+		}
+		input += me->col_count;
+	}
+}
@@ -0,0 +1,358 @@
+/*
+ * LedScript.c
+ *
+ *  Created on: 01-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "LedScript.h"
+#include "Port.h"
+#include "debug_logger.h"
+#include <string.h>
+
+static char *const tag = "LedScript";
+
+typedef struct {
+	uint8_t length;     // Opcode and operands, bytes
+	uint8_t pops;
+	uint8_t pushes;
+} LedScript_op_info_t;
+
+// Shared by the verifier and the stack guard in LedScript_step
+static const LedScript_op_info_t LED_SCRIPT_OPS[TOTAL_LS_OPS] =
+{
+	[LS_OP_END]     = { 1, 0, 0 },
+	[LS_OP_PUSH]    = { 3, 0, 1 },
+	[LS_OP_PUSHC]   = { 2, 0, 1 },
+	[LS_OP_DUP]     = { 1, 1, 2 },
+	[LS_OP_DROP]    = { 1, 1, 0 },
+	[LS_OP_GET]     = { 1, 0, 1 },
+	[LS_OP_PATTERN] = { 1, 1, 0 },
+	[LS_OP_BRIGHT]  = { 1, 1, 0 },
+	[LS_OP_SHL]     = { 2, 1, 1 },
+	[LS_OP_SHR]     = { 2, 1, 1 },
+	[LS_OP_ROL]     = { 2, 1, 1 },
+	[LS_OP_ROR]     = { 2, 1, 1 },
+	[LS_OP_AND]     = { 1, 2, 1 },
+	[LS_OP_OR]      = { 1, 2, 1 },
+	[LS_OP_XOR]     = { 1, 2, 1 },
+	[LS_OP_ADD]     = { 1, 2, 1 },
+	[LS_OP_RAND]    = { 1, 0, 1 },
+	[LS_OP_WAIT]    = { 2, 0, 0 },
+	[LS_OP_SETC]    = { 3, 0, 0 },
+	[LS_OP_DJNZ]    = { 3, 0, 0 },
+	[LS_OP_JZ]      = { 2, 1, 0 },
+	[LS_OP_JMP]     = { 2, 0, 0 },
+};
+
+// Byte offsets of the jump targets are noted on the left
+
+// One LED sweeping left and back
+static const uint8_t SCANNER[] = {
+	/*  0 */ LS_PUSH(0x0001), LS_PATTERN(),
+	/*  4 */ LS_SETC(0, 15),
+	/*  7 */ LS_WAIT(5), LS_GET(), LS_SHL(1), LS_PATTERN(), LS_DJNZ(0, 7),
+	/* 16 */ LS_SETC(0, 15),
+	/* 19 */ LS_WAIT(5), LS_GET(), LS_SHR(1), LS_PATTERN(), LS_DJNZ(0, 19),
+	/* 28 */ LS_JMP(4),
+};
+
+// LEDs light up one at a time, then go out in the same order
+static const uint8_t FILL[] = {
+	/*  0 */ LS_PUSH(0x0000), LS_PATTERN(),
+	/*  4 */ LS_SETC(0, 16),
+	/*  7 */ LS_GET(), LS_SHL(1), LS_PUSH(0x0001), LS_OR(), LS_PATTERN(), LS_WAIT(4), LS_DJNZ(0, 7),
+	/* 20 */ LS_SETC(0, 16),
+	/* 23 */ LS_GET(), LS_SHL(1), LS_PATTERN(), LS_WAIT(4), LS_DJNZ(0, 23),
+	/* 32 */ LS_JMP(4),
+};
+
+// All LEDs ramping brightness up, then down
+static const uint8_t BREATHE[] = {
+	/*  0 */ LS_PUSH(0xFFFF), LS_PATTERN(),
+	/*  4 */ LS_PUSH(0), LS_SETC(0, 10),
+	/* 10 */ LS_DUP(), LS_BRIGHT(), LS_PUSH(1), LS_ADD(), LS_WAIT(8), LS_DJNZ(0, 10),
+	/* 21 */ LS_DROP(), LS_SETC(0, 10),
+	/* 25 */ LS_PUSHC(0), LS_BRIGHT(), LS_WAIT(8), LS_DJNZ(0, 25),
+	/* 33 */ LS_JMP(4),
+};
+
+// Random patterns, one frame in four left dark
+static const uint8_t SPARKLE[] = {
+	/*  0 */ LS_RAND(), LS_PUSH(0x0003), LS_AND(), LS_JZ(13),
+	/*  7 */ LS_RAND(), LS_PATTERN(), LS_WAIT(8), LS_JMP(0),
+	/* 13 */ LS_PUSH(0x0000), LS_PATTERN(), LS_WAIT(8), LS_JMP(0),
+};
+
+#define PROGRAM(name, code) { (name), (code), sizeof(code) }
+
+// LedScript_benchmark runs the first one
+const LedScript_program_t LED_SCRIPT_BUILTINS[] = {
+	PROGRAM("Scanner", SCANNER),
+	PROGRAM("Fill", FILL),
+	PROGRAM("Breathe", BREATHE),
+	PROGRAM("Sparkle", SPARKLE),
+};
+const uint8_t LED_SCRIPT_BUILTIN_COUNT = sizeof(LED_SCRIPT_BUILTINS) / sizeof(LED_SCRIPT_BUILTINS[0]);
+
+bool LedScript_verify(const uint8_t *code, uint16_t length) {
+	uint8_t starts[LED_SCRIPT_MAX_CODE / 8] = { 0 };
+	uint16_t pc = 0;
+	uint8_t op = LS_OP_END;
+
+	if (code == NULL || length == 0 || length > LED_SCRIPT_MAX_CODE) {
+		return false;
+	}
+
+	// Pass 1: opcodes, operands and instruction boundaries
+	while (pc < length) {
+		op = code[pc];
+		if (op >= TOTAL_LS_OPS || pc + LED_SCRIPT_OPS[op].length > length) {
+			return false;
+		}
+		const uint8_t *arg = &code[pc + 1];
+		switch (op) {
+		case LS_OP_SHL:
+		case LS_OP_SHR:
+		case LS_OP_ROL:
+		case LS_OP_ROR:
+			if (arg[0] > 15) {
+				return false;
+			}
+			break;
+		case LS_OP_PUSHC:
+		case LS_OP_SETC:
+		case LS_OP_DJNZ:
+			if (arg[0] >= LED_SCRIPT_COUNTERS) {
+				return false;
+			}
+			break;
+		default:
+			break;
+		}
+		starts[pc / 8] |= (uint8_t) (1U << (pc % 8));
+		pc += LED_SCRIPT_OPS[op].length;
+	}
+	// Execution never runs off the end
+	if (op != LS_OP_END && op != LS_OP_JMP) {
+		return false;
+	}
+
+	// Pass 2: every jump lands on an instruction
+	for (pc = 0; pc < length; pc += LED_SCRIPT_OPS[code[pc]].length) {
+		uint8_t target;
+		switch (code[pc]) {
+		case LS_OP_DJNZ:
+			target = code[pc + 2];
+			break;
+		case LS_OP_JZ:
+		case LS_OP_JMP:
+			target = code[pc + 1];
+			break;
+		default:
+			continue;
+		}
+		if (target >= length || (starts[target / 8] & (1U << (target % 8))) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LedScript_load(LedScript_t * const me, const uint8_t *code, uint16_t length,
+		uint8_t brightness, uint32_t seed) {
+	if (!LedScript_verify(code, length)) {
+		return false;
+	}
+
+	memset(me, 0, sizeof(*me));
+	me->code = code;
+	me->length = length;
+	me->brightness = (brightness > LED_SCRIPT_MAX_BRIGHTNESS) ? LED_SCRIPT_MAX_BRIGHTNESS : brightness;
+	me->random = (seed != 0) ? seed : 0x2545F491UL;
+	return true;
+}
+
+#define TOP (me->stack[me->sp - 1])
+
+// Every instruction is constant time, so the op budget bounds the cycles
+LedScript_status_e LedScript_step(LedScript_t * const me) {
+	LedScript_status_e status = LED_SCRIPT_YIELD;
+	uint8_t ops = 0;
+	uint16_t value;
+
+	if (me->is_stopped) {
+		return LED_SCRIPT_DONE;
+	}
+
+	uint32_t start = Port_cycles();
+	while (ops < LED_SCRIPT_STEP_OPS) {
+		uint8_t op = me->code[me->pc];
+		const uint8_t *arg = &me->code[me->pc + 1];
+		const LedScript_op_info_t *info = &LED_SCRIPT_OPS[op];
+
+		ops++;
+		if (me->sp < info->pops || me->sp - info->pops + info->pushes > LED_SCRIPT_STACK_DEPTH) {
+			me->stats.faults++;
+			me->is_stopped = true;
+			status = LED_SCRIPT_FAULT;
+			break;
+		}
+		me->pc += info->length;
+
+		switch (op) {
+		case LS_OP_END:
+			me->is_stopped = true;
+			status = LED_SCRIPT_DONE;
+			break;
+		case LS_OP_PUSH:
+			me->stack[me->sp++] = (uint16_t) (arg[0] | (arg[1] << 8));
+			break;
+		case LS_OP_PUSHC:
+			me->stack[me->sp++] = me->counters[arg[0]];
+			break;
+		case LS_OP_DUP:
+			value = TOP;
+			me->stack[me->sp++] = value;
+			break;
+		case LS_OP_DROP:
+			me->sp--;
+			break;
+		case LS_OP_GET:
+			me->stack[me->sp++] = me->pattern;
+			break;
+		case LS_OP_PATTERN:
+			me->pattern = me->stack[--me->sp];
+			break;
+		case LS_OP_BRIGHT:
+			value = me->stack[--me->sp];
+			me->brightness = (value > LED_SCRIPT_MAX_BRIGHTNESS) ? LED_SCRIPT_MAX_BRIGHTNESS : (uint8_t) value;
+			break;
+		case LS_OP_SHL:
+			TOP = (uint16_t) (TOP << arg[0]);
+			break;
+		case LS_OP_SHR:
+			TOP = (uint16_t) (TOP >> arg[0]);
+			break;
+		case LS_OP_ROL:
+			TOP = (uint16_t) ((TOP << arg[0]) | (TOP >> ((16 - arg[0]) & 15)));
+			break;
+		case LS_OP_ROR:
+			TOP = (uint16_t) ((TOP >> arg[0]) | (TOP << ((16 - arg[0]) & 15)));
+			break;
+		case LS_OP_AND:
+			value = me->stack[--me->sp];
+			TOP &= value;
+			break;
+		case LS_OP_OR:
+			value = me->stack[--me->sp];
+			TOP |= value;
+			break;
+		case LS_OP_XOR:
+			value = me->stack[--me->sp];
+			TOP ^= value;
+			break;
+		case LS_OP_ADD:
+			value = me->stack[--me->sp];
+			TOP += value;
+			break;
+		case LS_OP_RAND:
+			me->random ^= me->random << 13;
+			me->random ^= me->random >> 17;
+			me->random ^= me->random << 5;
+			me->stack[me->sp++] = (uint16_t) (me->random >> 16);
+			break;
+		case LS_OP_WAIT:
+			me->wait_ms = (uint16_t) (arg[0] * LED_SCRIPT_WAIT_UNIT_MS);
+			status = LED_SCRIPT_WAIT;
+			break;
+		case LS_OP_SETC:
+			me->counters[arg[0]] = arg[1];
+			break;
+		case LS_OP_DJNZ:
+			if (--me->counters[arg[0]] != 0) {
+				me->pc = arg[1];
+			}
+			break;
+		case LS_OP_JZ:
+			if (me->stack[--me->sp] == 0) {
+				me->pc = arg[0];
+			}
+			break;
+		case LS_OP_JMP:
+			me->pc = arg[0];
+			break;
+		default:
+			break;
+		}
+		if (status != LED_SCRIPT_YIELD) {
+			break;
+		}
+	}
+	uint32_t cycles = Port_cycles() - start;
+
+	LedScript_stats_t *stats = &me->stats;
+	stats->steps++;
+	stats->ops += ops;
+	if (status == LED_SCRIPT_YIELD) {
+		stats->yields++;
+	}
+	if (ops > stats->max_ops) {
+		stats->max_ops = ops;
+	}
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+	return status;
+}
+
+void LedScript_get_stats(const LedScript_t * const me, LedScript_stats_t *out) {
+	*out = me->stats;
+}
+
+// SCANNER written in C: 30 frames, the LED goes 0 -> 15 -> 1
+static uint16_t native_scanner(uint8_t *frame) {
+	uint8_t i = *frame;
+
+	*frame = (i + 1 < 30) ? i + 1 : 0;
+	return (uint16_t) (1U << ((i <= 15) ? i : 30 - i));
+}
+
+void LedScript_benchmark(uint16_t frames) {
+	const LedScript_program_t *program = &LED_SCRIPT_BUILTINS[0];
+	LedScript_t script;
+	uint8_t frame = 0;
+	uint16_t mismatches = 0;
+	volatile uint16_t sink = 0; // Keeps the frames alive
+
+	if (frames == 0 || !LedScript_load(&script, program->code, program->length, 0, 0)) {
+		return;
+	}
+
+	uint32_t start = Port_cycles();
+	for (uint16_t i = 0; i < frames; i++) {
+		LedScript_step(&script);
+		sink ^= script.pattern;
+	}
+	uint32_t script_cycles = (Port_cycles() - start) / frames;
+
+	start = Port_cycles();
+	for (uint16_t i = 0; i < frames; i++) {
+		sink ^= native_scanner(&frame);
+	}
+	uint32_t native_cycles = (Port_cycles() - start) / frames;
+
+	// Same frames from both, one step per frame
+	LedScript_load(&script, program->code, program->length, 0, 0);
+	frame = 0;
+	for (uint16_t i = 0; i < frames; i++) {
+		if (LedScript_step(&script) != LED_SCRIPT_WAIT || script.pattern != native_scanner(&frame)) {
+			mismatches++;
+		}
+	}
+
+	log_message(tag, LOG_INFO,
+			"%s: script %lu cycles/frame (at most %u ops, %lu cycles per step), native %lu cycles/frame, %u of %u frames differ",
+			program->name, script_cycles, script.stats.max_ops, script.stats.max_cycles,
+			native_cycles, mismatches, frames);
+}
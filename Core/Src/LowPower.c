@@ -0,0 +1,114 @@
+/*
+ * LowPower.c
+ *
+ *  Created on: 31-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "LowPower.h"
+#include "Clock.h"
+#include "cmsis_os.h"
+
+static LowPower_stats_t stats;
+
+// BKP0R..BKP19R are consecutive
+static volatile uint32_t *const backup = &RTC->BKP0R;
+
+static uint32_t check_word(const uint32_t *words, uint8_t count) {
+	uint32_t check = ~LOW_POWER_MAGIC;
+	for (uint8_t i = 0; i < count; i++) {
+		check = ((check << 5) | (check >> 27)) ^ words[i];
+	}
+	return check;
+}
+
+static void backup_unlock(void) {
+	__HAL_RCC_PWR_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+}
+
+void LowPower_save(const uint32_t *words, uint8_t count) {
+	if (count > LOW_POWER_STATE_WORDS) {
+		count = LOW_POWER_STATE_WORDS;
+	}
+
+	backup_unlock();
+	for (uint8_t i = 0; i < count; i++) {
+		backup[1 + i] = words[i];
+	}
+	backup[1 + LOW_POWER_STATE_WORDS] = check_word(words, count);
+	// Marker last, a reset half-way leaves no state rather than a torn one
+	backup[0] = LOW_POWER_MAGIC;
+	HAL_PWR_DisableBkUpAccess();
+}
+
+bool LowPower_load(uint32_t *words, uint8_t count) {
+	if (count > LOW_POWER_STATE_WORDS || backup[0] != LOW_POWER_MAGIC) {
+		return false;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		words[i] = backup[1 + i];
+	}
+	return backup[1 + LOW_POWER_STATE_WORDS] == check_word(words, count);
+}
+
+void LowPower_clear(void) {
+	backup_unlock();
+	backup[0] = 0;
+	HAL_PWR_DisableBkUpAccess();
+}
+
+// STOP wakes on HSI. The PLL settings, bus prescalers and flash latency
+// are kept, so only the oscillators need restarting; SystemClock_Config
+// would also re-run HAL_InitTick and reset the microsecond clock.
+static void restore_clocks(void) {
+	RCC->CR |= RCC_CR_HSEON;
+	while ((RCC->CR & RCC_CR_HSERDY) == 0) {
+	}
+	RCC->CR |= RCC_CR_PLLON;
+	while ((RCC->CR & RCC_CR_PLLRDY) == 0) {
+	}
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+	while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL) {
+	}
+}
+
+void LowPower_stop(void) {
+	// No task switch and no interrupt handler until the clocks are back
+	osKernelLock();
+	HAL_SuspendTick();
+	__disable_irq();
+	// The RTOS tick would end STOP within a millisecond
+	uint32_t systick = SysTick->CTRL;
+	SysTick->CTRL = systick & ~(SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk);
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+
+	// A press since the caller checked is already pending and wakes the
+	// core straight away
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+	// DWT counts core cycles: HSI until the switch, the PLL after it
+	uint32_t start = DWT->CYCCNT;
+	restore_clocks();
+	uint32_t hsi_cycles = DWT->CYCCNT - start;
+	start = DWT->CYCCNT;
+	HAL_ResumeTick();
+	SysTick->CTRL = systick;
+	uint32_t pll_cycles = DWT->CYCCNT - start;
+
+	uint32_t resume_us = hsi_cycles / (HSI_VALUE / 1000000U)
+			+ pll_cycles / (SystemCoreClock / 1000000U);
+	stats.stops++;
+	stats.last_resume_us = resume_us;
+	if (resume_us > stats.max_resume_us) {
+		stats.max_resume_us = resume_us;
+	}
+	stats.wake_time = Clock_now_us();
+
+	__enable_irq();
+	osKernelUnlock();
+}
+
+void LowPower_get_stats(LowPower_stats_t *out) {
+	*out = stats;
+}
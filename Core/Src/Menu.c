@@ -7,6 +7,7 @@
 
 #include "Menu.h"
 #include "debug_logger.h"
+#include <string.h>
 
 #define Firmware_V_MAJOR	10
 #define Firmware_V_Minor	5
@@ -17,10 +18,24 @@
 #define MAX_BRIGHTNESS		10
 #define MIN_BRIGHTNESS		0
 
+// Auto mode pattern period, halved or doubled per speed step
+#define DEFAULT_AUTO_PERIOD_MS	2000
+#define MIN_AUTO_PERIOD_MS		250
+#define MAX_AUTO_PERIOD_MS		8000
+
 static char *const tag = "Menu";
 
+// Log lines from inside a batch are only counted
+#define MENU_LOG(me, level, ...) do { \
+		if ((me)->batch.is_active) { \
+			(me)->batch_stats.logs_skipped++; \
+		} else { \
+			log_message(tag, (level), __VA_ARGS__); \
+		} \
+	} while (0)
+
 // Predefined LED patterns for Manual Mode cycling
-static uint16_t LED_PATTERNS[] = {
+static const uint16_t LED_PATTERNS[] = {
 	0x0001, // Pattern 1
 	0x0003, // Pattern 2
 	0x0007, // Pattern 3
@@ -40,7 +55,7 @@ static uint16_t LED_PATTERNS[] = {
 };
 #define TOTAL_PATTERNS (sizeof(LED_PATTERNS)/sizeof(LED_PATTERNS[0]))
 
-static uint16_t MENU_TO_PAGES[TOTAL_PAGES] =
+static const uint16_t MENU_TO_PAGES[TOTAL_PAGES] =
 {
 	0x1000, 	// BRIGHTNESS_PAGE = 0
 	0x2000, 	// MODE_SELECT_PAGE,
@@ -52,49 +67,283 @@ static uint16_t MENU_TO_PAGES[TOTAL_PAGES] =
 	0xffff,		// MANUAL_MODE,
 	0xffff,		// AUTO_MODE,
 	FIRMWARE_V_Disp,// FIRMWARE_VER,
-	0x80FF		// RESET_CONFIRM
+	0x80FF,		// RESET_CONFIRM
+	0x0000		// POWER_OFF
 };
 
-// Menu state variables
+// What a transition does besides moving to its next page
+typedef enum {
+	MENU_ACT_NONE = 0,		// Event ignored on this page
+	MENU_ACT_GOTO,
+	MENU_ACT_POWER_OFF,
+	MENU_ACT_POWER_ON,
+	MENU_ACT_OPEN_MODE,		// Next page is the saved Manual/Auto selection
+	MENU_ACT_SELECT_MODE,
+	MENU_ACT_ENTER_MANUAL,
+	MENU_ACT_ENTER_AUTO,
+	MENU_ACT_EXIT_AUTO,
+	MENU_ACT_BRIGHTNESS_UP,
+	MENU_ACT_BRIGHTNESS_DOWN,
+	MENU_ACT_NEXT_PATTERN,
+	MENU_ACT_AUTO_FASTER,
+	MENU_ACT_AUTO_SLOWER,
+	MENU_ACT_NEXT_SCRIPT,
+	MENU_ACT_INFO_NEXT,
+	MENU_ACT_RESET,
+	TOTAL_MENU_ACTS
+} Menu_action_e;
+
+// Frame sent after an action
+typedef enum {
+	MENU_FRAME_NONE = 0,
+	MENU_FRAME_PAGE,		// MENU_TO_PAGES of the next page
+	MENU_FRAME_ACTION		// me->pattern as set by the action
+} Menu_frame_e;
+
 typedef struct {
-	uint8_t brightness;
-	uint8_t current_pattern_index;
-	bool is_auto_mode;
-	bool is_powered_on;
-	Menu_State_e saved_mode_selection; // To track Manual vs Auto in Mode Select
-} Menu_Settings_t;
+	uint8_t next;			// Menu_State_e
+	uint8_t action;			// Menu_action_e
+} Menu_transition_t;
+
+#define GO(page)			{ .next = (page), .action = MENU_ACT_GOTO }
+#define DO(act, page)		{ .next = (page), .action = (act) }
+
+// The whole menu as data, [page][button][event]; entries left out are
+// MENU_ACT_NONE. Page patterns are per page, in MENU_TO_PAGES.
+static const Menu_transition_t MENU_TRANSITIONS[TOTAL_PAGES][TOTAL_BTNS][TOTAL_BTN_EVENTS] =
+{
+	[BRIGHTNESS_PAGE] = {
+		[BTN_1] = { [SINGLE_PRESS] = GO(MODE_SELECT_PAGE) },
+		[BTN_2] = { [SINGLE_PRESS] = GO(BRIGHTNESS_SETTING) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(RESET_PAGE),
+					[LONG_PRESS] = DO(MENU_ACT_POWER_OFF, POWER_OFF) },
+	},
+	[MODE_SELECT_PAGE] = {
+		[BTN_1] = { [SINGLE_PRESS] = GO(INFO_PAGE) },
+		[BTN_2] = { [SINGLE_PRESS] = DO(MENU_ACT_OPEN_MODE, MODE_MANUAL_PAGE) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(BRIGHTNESS_PAGE),
+					[LONG_PRESS] = DO(MENU_ACT_POWER_OFF, POWER_OFF) },
+	},
+	[INFO_PAGE] = {
+		[BTN_1] = { [SINGLE_PRESS] = GO(RESET_PAGE) },
+		[BTN_2] = { [SINGLE_PRESS] = GO(FIRMWARE_VER) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(MODE_SELECT_PAGE),
+					[LONG_PRESS] = DO(MENU_ACT_POWER_OFF, POWER_OFF) },
+	},
+	[RESET_PAGE] = {
+		[BTN_1] = { [SINGLE_PRESS] = GO(BRIGHTNESS_PAGE) },
+		[BTN_2] = { [SINGLE_PRESS] = GO(RESET_CONFIRM) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(INFO_PAGE),
+					[LONG_PRESS] = DO(MENU_ACT_POWER_OFF, POWER_OFF) },
+	},
+	[MODE_MANUAL_PAGE] = {
+		[BTN_1] = { [SINGLE_PRESS] = DO(MENU_ACT_SELECT_MODE, MODE_AUTO_PAGE) },
+		[BTN_2] = { [SINGLE_PRESS] = DO(MENU_ACT_ENTER_MANUAL, MANUAL_MODE) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(MODE_SELECT_PAGE) },
+	},
+	[MODE_AUTO_PAGE] = {
+		[BTN_1] = { [SINGLE_PRESS] = DO(MENU_ACT_SELECT_MODE, MODE_MANUAL_PAGE) },
+		[BTN_2] = { [SINGLE_PRESS] = DO(MENU_ACT_ENTER_AUTO, AUTO_MODE) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(MODE_SELECT_PAGE) },
+	},
+	[BRIGHTNESS_SETTING] = {
+		[BTN_1] = { [SINGLE_PRESS] = GO(BRIGHTNESS_PAGE) },
+		// Holding BTN2/BTN3 steps brightness repeatedly
+		[BTN_2] = { [SINGLE_PRESS] = DO(MENU_ACT_BRIGHTNESS_UP, BRIGHTNESS_SETTING),
+					[REPEAT] = DO(MENU_ACT_BRIGHTNESS_UP, BRIGHTNESS_SETTING) },
+		[BTN_3] = { [SINGLE_PRESS] = DO(MENU_ACT_BRIGHTNESS_DOWN, BRIGHTNESS_SETTING),
+					[REPEAT] = DO(MENU_ACT_BRIGHTNESS_DOWN, BRIGHTNESS_SETTING) },
+	},
+	[MANUAL_MODE] = {
+		// Holding BTN1 keeps cycling patterns
+		[BTN_1] = { [SINGLE_PRESS] = DO(MENU_ACT_NEXT_PATTERN, MANUAL_MODE),
+					[REPEAT] = DO(MENU_ACT_NEXT_PATTERN, MANUAL_MODE) },
+		[BTN_2] = { [SINGLE_PRESS] = GO(MODE_SELECT_PAGE) },	// Keep the pattern
+		[BTN_3] = { [SINGLE_PRESS] = GO(MODE_SELECT_PAGE) },	// Cancel
+	},
+	[AUTO_MODE] = {
+		[BTN_1] = { [SINGLE_PRESS] = DO(MENU_ACT_EXIT_AUTO, MODE_MANUAL_PAGE),
+					[DOUBLE_PRESS] = DO(MENU_ACT_NEXT_SCRIPT, AUTO_MODE) },
+		[BTN_2] = { [SINGLE_PRESS] = DO(MENU_ACT_AUTO_FASTER, AUTO_MODE) },
+		[BTN_3] = { [SINGLE_PRESS] = DO(MENU_ACT_AUTO_SLOWER, AUTO_MODE) },
+	},
+	[FIRMWARE_VER] = {
+		[BTN_1] = { [SINGLE_PRESS] = DO(MENU_ACT_INFO_NEXT, FIRMWARE_VER) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(INFO_PAGE) },
+	},
+	[RESET_CONFIRM] = {
+		[BTN_2] = { [DOUBLE_PRESS] = DO(MENU_ACT_RESET, BRIGHTNESS_PAGE) },
+		[BTN_3] = { [SINGLE_PRESS] = GO(RESET_PAGE) },
+	},
+	[POWER_OFF] = {
+		// Only BTN1 long press restarts
+		[BTN_1] = { [LONG_PRESS] = DO(MENU_ACT_POWER_ON, BRIGHTNESS_PAGE) },
+	},
+};
 
-static Menu_Settings_t menu_settings;
+// Returns false if there is nothing to do (a limit is reached), leaving the
+// page as it is. May redirect next.
+typedef bool (*Menu_action_fn)(Menu_t * const me, Menu_State_e *next);
+
+typedef struct {
+	const char *name;
+	Menu_action_fn run;		// NULL: only moves to the next page
+	Menu_frame_e frame;
+} Menu_action_t;
 
 // Forward declarations for helper functions
 static void send_display_update(Menu_t * const me, uint16_t pattern, uint8_t brightness);
+static void send_display_activity(Menu_t * const me);
 static uint16_t get_brightness_pattern(uint8_t brightness);
+static void show_page(Menu_t * const me);
+
+// Persisted part of Menu_Settings_t, SETTINGS_STORE_DATA_SIZE bytes;
+// auto mode itself is not restored, the menu always boots to its first page
+static void encode_settings(const Menu_Settings_t *settings, uint8_t *data) {
+	memset(data, 0, SETTINGS_STORE_DATA_SIZE);
+	data[0] = settings->brightness;
+	data[1] = settings->current_pattern_index;
+	data[2] = (uint8_t) settings->saved_mode_selection;
+	data[3] = (uint8_t) settings->auto_period_ms;
+	data[4] = (uint8_t) (settings->auto_period_ms >> 8);
+	// An uploaded script is gone after a reset
+	data[5] = (settings->auto_script <= LED_SCRIPT_BUILTIN_COUNT) ? settings->auto_script : 0;
+}
 
-void Menu_ctor(Menu_t * const me, osMessageQueueId_t queue_handler) {
+// Ignores a record from another firmware that does not fit this menu
+static bool decode_settings(const uint8_t *data, Menu_Settings_t *settings) {
+	uint16_t auto_period_ms = (uint16_t) (data[3] | (data[4] << 8));
+
+	if (data[0] > MAX_BRIGHTNESS || data[1] >= TOTAL_PATTERNS
+			|| (data[2] != MODE_MANUAL_PAGE && data[2] != MODE_AUTO_PAGE)
+			|| auto_period_ms < MIN_AUTO_PERIOD_MS
+			|| auto_period_ms > MAX_AUTO_PERIOD_MS
+			|| data[5] > LED_SCRIPT_BUILTIN_COUNT) {
+		return false;
+	}
+	settings->brightness = data[0];
+	settings->current_pattern_index = data[1];
+	settings->saved_mode_selection = (Menu_State_e) data[2];
+	settings->auto_period_ms = auto_period_ms;
+	settings->auto_script = data[5];
+	return true;
+}
+
+// Hands the settings to the store, which coalesces changes until idle
+static void persist_settings(Menu_t * const me) {
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+
+	if (me->store != NULL) {
+		encode_settings(&me->settings, data);
+		SettingsStore_save(me->store, data);
+	}
+}
+
+// Defaults shared by a cold start and a resume
+static void init_state(Menu_t * const me, Display_channel_t *display_channel, SettingsStore_t *store) {
 	me->current_page = BRIGHTNESS_PAGE;
 	me->pattern = MENU_TO_PAGES[BRIGHTNESS_PAGE];
-	me->queue_handler = queue_handler;
+	me->display_channel = display_channel;
+	me->store = store;
+	me->batch = (Menu_batch_t ) { 0 };
+	me->batch_stats = (Menu_batch_stats_t ) { 0 };
+	me->dispatch_stats = (Menu_dispatch_stats_t ) { 0 };
 
 	// Initialize default settings
-	menu_settings.brightness = DEFAULT_BRIGHTNESS;
-	menu_settings.current_pattern_index = DEFAULT_PATTERN;
-	menu_settings.is_auto_mode = false;
-	menu_settings.is_powered_on = true;
-	menu_settings.saved_mode_selection = MODE_MANUAL_PAGE;
+	me->settings.brightness = DEFAULT_BRIGHTNESS;
+	me->settings.current_pattern_index = DEFAULT_PATTERN;
+	me->settings.is_auto_mode = false;
+	me->settings.saved_mode_selection = MODE_MANUAL_PAGE;
+	me->settings.auto_period_ms = DEFAULT_AUTO_PERIOD_MS;
+	me->settings.auto_script = 0;
+	me->speculation.is_active = false;
+	me->script_loaded = 0;
+	me->uploaded_length = 0;
+}
+
+void Menu_ctor(Menu_t * const me, Display_channel_t *display_channel, SettingsStore_t *store) {
+	init_state(me, display_channel, store);
+
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	bool is_restored = (store != NULL) && SettingsStore_load(store, data)
+			&& decode_settings(data, &me->settings);
 
 	// Send initial display state
-	send_display_update(me, me->pattern, menu_settings.brightness);
+	send_display_update(me, me->pattern, me->settings.brightness);
+
+	log_message(tag, LOG_INFO, "Menu initialized - Page: %d, Brightness: %d, transition table %u bytes, settings %s",
+	            me->current_page, me->settings.brightness, (unsigned) sizeof(MENU_TRANSITIONS),
+	            is_restored ? "restored" : "defaults");
+}
+
+// Snapshot layout: words 0-1 the encoded settings, word 2 page in bits 0-7,
+// auto mode in bit 8 and the pattern in bits 16-31
+bool Menu_resume_ctor(Menu_t * const me, Display_channel_t *display_channel, SettingsStore_t *store,
+		const uint32_t *words) {
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	Menu_State_e page = (Menu_State_e) (words[2] & 0xFF);
+
+	memcpy(data, words, SETTINGS_STORE_DATA_SIZE);
+	init_state(me, display_channel, store);
+	if (page >= TOTAL_PAGES || !decode_settings(data, &me->settings)) {
+		return false;
+	}
+	me->current_page = page;
+	me->pattern = (uint16_t) (words[2] >> 16);
+	me->settings.is_auto_mode = (words[2] & (1UL << 8)) != 0;
+
+	// The first frame is the only output, no log
+	show_page(me);
+	return true;
+}
+
+void Menu_get_snapshot(const Menu_t * const me, uint32_t *words) {
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
 
-	log_message(tag, LOG_INFO, "Menu initialized - Page: %d, Brightness: %d",
-	            me->current_page, menu_settings.brightness);
+	encode_settings(&me->settings, data);
+	memcpy(words, data, SETTINGS_STORE_DATA_SIZE);
+	words[2] = (uint32_t) me->current_page
+			| ((me->settings.is_auto_mode ? 1UL : 0UL) << 8)
+			| ((uint32_t) me->pattern << 16);
 }
 
 static void send_display_update(Menu_t * const me, uint16_t pattern, uint8_t brightness) {
-	Display_update_data_t display_data;
-	display_data.data = pattern;
-	display_data.brightness = brightness;
+	if (me->batch.is_active) {
+		if (me->batch.is_frame_pending) {
+			me->batch_stats.frames_skipped++;
+		}
+		me->batch.is_frame_pending = true;
+		me->batch.pattern = pattern;
+		me->batch.brightness = brightness;
+		return;
+	}
+
+	Display_msg_t *display_msg = Display_channel_alloc(me->display_channel);
+	if (display_msg == NULL) {
+		return; // Pool exhausted, counted by the channel
+	}
+
+	display_msg->type = DISPLAY_MSG_UPDATE;
+	display_msg->update.data = pattern;
+	display_msg->update.brightness = brightness;
+	display_msg->update.timestamp = Port_now_us();
+
+	Display_channel_send(me->display_channel, display_msg);
+}
+
+static void send_display_activity(Menu_t * const me) {
+	if (me->batch.is_active) {
+		me->batch.is_activity_pending = true;
+		return;
+	}
 
-	osMessageQueuePut(me->queue_handler, &display_data, 0U, 0U);
+	Display_msg_t *display_msg = Display_channel_alloc(me->display_channel);
+	if (display_msg == NULL) {
+		return; // Pool exhausted, counted by the channel
+	}
+
+	display_msg->type = DISPLAY_MSG_ACTIVITY;
+	Display_channel_send(me->display_channel, display_msg);
 }
 
 static uint16_t get_brightness_pattern(uint8_t brightness) {
@@ -104,295 +353,401 @@ static uint16_t get_brightness_pattern(uint8_t brightness) {
 	return ((1 << brightness) - 1) & MENU_TO_PAGES[BRIGHTNESS_SETTING]; // mask the output
 }
 
-static void handle_main_menu(Menu_t * const me, const BTN_event_t event) {
-	switch(event.type) {
-		case SINGLE_PRESS:
-			if (event.id == BTN_1) {
-				// Move selection forward
-				if (me->current_page < RESET_PAGE) {
-					me->current_page++;
-				} else {
-					me->current_page = BRIGHTNESS_PAGE;
-				}
-				me->pattern = MENU_TO_PAGES[me->current_page];
-				send_display_update(me, me->pattern, menu_settings.brightness);
-				log_message(tag, LOG_INFO, "Main Menu: Selected page %d", me->current_page);
-			}
-			else if (event.id == BTN_2) {
-				// Enter selected item
-				Menu_State_e next_page = me->current_page;
-
-				switch(me->current_page) {
-					case BRIGHTNESS_PAGE:
-						next_page = BRIGHTNESS_SETTING;
-						break;
-					case MODE_SELECT_PAGE:
-						next_page = menu_settings.saved_mode_selection;
-						break;
-					case INFO_PAGE:
-						next_page = FIRMWARE_VER;
-						break;
-					case RESET_PAGE:
-						next_page = RESET_CONFIRM;
-					default:
-						break;
-				}
-
-				me->current_page = next_page;
-				me->pattern = MENU_TO_PAGES[me->current_page];
-				send_display_update(me, me->pattern, menu_settings.brightness);
-				log_message(tag, LOG_INFO, "Main Menu: Entered page %d", me->current_page);
-			}
-			else if (event.id == BTN_3) {
-				// Move selection backward
-				if (me->current_page > BRIGHTNESS_PAGE) {
-					me->current_page--;
-				} else {
-					me->current_page = RESET_PAGE;
-				}
-				me->pattern = MENU_TO_PAGES[me->current_page];
-				send_display_update(me, me->pattern, menu_settings.brightness);
-				log_message(tag, LOG_INFO, "Main Menu: Selected page %d", me->current_page);
-			}
-			break;
-
-		case LONG_PRESS:
-			if (event.id == BTN_3) {
-				// Power off
-				menu_settings.is_powered_on = false;
-				send_display_update(me, 0x0000, 0);
-				log_message(tag, LOG_INFO, "Power OFF");
-			}
-			break;
+static void change_page(Menu_t * const me, Menu_State_e page) {
+	me->current_page = page;
+	me->pattern = MENU_TO_PAGES[page];
+}
 
-		default:
-			break;
+// Powered off shows a blank frame at zero brightness
+static void show_page(Menu_t * const me) {
+	if (me->current_page == POWER_OFF) {
+		send_display_update(me, 0x0000, 0);
+	} else {
+		send_display_update(me, me->pattern, me->settings.brightness);
 	}
 }
 
-static void handle_brightness_setting(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == SINGLE_PRESS) {
-		if (event.id == BTN_2) {
-			// Increase brightness
-			if (menu_settings.brightness < MAX_BRIGHTNESS) {
-				menu_settings.brightness++;
-				me->pattern = get_brightness_pattern(menu_settings.brightness);
-				send_display_update(me, me->pattern, menu_settings.brightness);
-				log_message(tag, LOG_INFO, "Brightness increased to %d", menu_settings.brightness);
-			}
-		}
-		else if (event.id == BTN_3) {
-			// Decrease brightness
-			if (menu_settings.brightness > MIN_BRIGHTNESS) {
-				menu_settings.brightness--;
-				me->pattern = get_brightness_pattern(menu_settings.brightness);
-				send_display_update(me, me->pattern, menu_settings.brightness);
-				log_message(tag, LOG_INFO, "Brightness decreased to %d", menu_settings.brightness);
-			}
-		}
-		else if (event.id == BTN_1) {
-			// Return to main menu
-			me->current_page = BRIGHTNESS_PAGE;
-			me->pattern = MENU_TO_PAGES[me->current_page];
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Returned to Main Menu from Brightness");
-		}
-	}
+static bool act_open_mode(Menu_t * const me, Menu_State_e *next) {
+	*next = me->settings.saved_mode_selection;
+	return true;
 }
 
-static void handle_mode_select(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == SINGLE_PRESS) {
-		if (event.id == BTN_1) {
-			// Toggle Manual or Auto
-			if (menu_settings.saved_mode_selection == MODE_MANUAL_PAGE) {
-				menu_settings.saved_mode_selection = MODE_AUTO_PAGE;
-				me->pattern = MENU_TO_PAGES[MODE_AUTO_PAGE];
-			} else {
-				menu_settings.saved_mode_selection = MODE_MANUAL_PAGE;
-				me->pattern = MENU_TO_PAGES[MODE_MANUAL_PAGE];
-			}
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Mode toggled to %s",
-			            (menu_settings.saved_mode_selection == MODE_MANUAL_PAGE) ? "Manual" : "Auto");
-		}
-		else if (event.id == BTN_2) {
-			// Enter selected mode
-			if (menu_settings.saved_mode_selection == MODE_MANUAL_PAGE) {
-				me->current_page = MANUAL_MODE;
-				me->pattern = LED_PATTERNS[menu_settings.current_pattern_index];
-			} else {
-				me->current_page = AUTO_MODE;
-				me->pattern = LED_PATTERNS[menu_settings.current_pattern_index];
-				menu_settings.is_auto_mode = true;
-			}
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Entered %s mode",
-			            (me->current_page == MANUAL_MODE) ? "Manual" : "Auto");
-		}
-		else if (event.id == BTN_3) {
-			// Cancel and return to main menu
-			me->current_page = MODE_SELECT_PAGE;
-			me->pattern = MENU_TO_PAGES[MODE_SELECT_PAGE];
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Cancelled mode selection");
-		}
+// The mode select page shown is always the saved selection
+static bool act_select_mode(Menu_t * const me, Menu_State_e *next) {
+	me->settings.saved_mode_selection = *next;
+	return true;
+}
+
+static bool act_enter_manual(Menu_t * const me, Menu_State_e *next) {
+	me->pattern = LED_PATTERNS[me->settings.current_pattern_index];
+	return true;
+}
+
+static bool act_enter_auto(Menu_t * const me, Menu_State_e *next) {
+	me->settings.is_auto_mode = true;
+	me->pattern = LED_PATTERNS[me->settings.current_pattern_index];
+	return true;
+}
+
+static bool act_exit_auto(Menu_t * const me, Menu_State_e *next) {
+	me->settings.is_auto_mode = false;
+	me->settings.saved_mode_selection = *next;
+	return true;
+}
+
+static bool act_brightness_up(Menu_t * const me, Menu_State_e *next) {
+	if (me->settings.brightness >= MAX_BRIGHTNESS) {
+		return false;
 	}
+	me->settings.brightness++;
+	me->pattern = get_brightness_pattern(me->settings.brightness);
+	return true;
 }
 
-static void handle_manual_mode(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == SINGLE_PRESS) {
-		if (event.id == BTN_1) {
-			// Cycle LED patterns
-			menu_settings.current_pattern_index++;
-			if (menu_settings.current_pattern_index >= TOTAL_PATTERNS) {
-				menu_settings.current_pattern_index = 0;
-			}
-			me->pattern = LED_PATTERNS[menu_settings.current_pattern_index];
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Manual Mode: Pattern %d selected",
-			            menu_settings.current_pattern_index);
-		}
-		else if (event.id == BTN_2) {
-			// Save and return to main menu
-			me->current_page = MODE_SELECT_PAGE;
-			me->pattern = MENU_TO_PAGES[MODE_SELECT_PAGE];
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Manual Mode: Saved pattern %d",
-			            menu_settings.current_pattern_index);
-		}
-		else if (event.id == BTN_3) {
-			// Cancel - return to mode select without saving
-			me->current_page = MODE_SELECT_PAGE;
-			me->pattern = MENU_TO_PAGES[MODE_SELECT_PAGE];
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Manual Mode: Cancelled");
-		}
+static bool act_brightness_down(Menu_t * const me, Menu_State_e *next) {
+	if (me->settings.brightness <= MIN_BRIGHTNESS) {
+		return false;
 	}
+	me->settings.brightness--;
+	me->pattern = get_brightness_pattern(me->settings.brightness);
+	return true;
 }
 
-static void handle_auto_mode(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == SINGLE_PRESS && event.id == BTN_1) {
-		// Exit Auto and return to mode select
-		menu_settings.is_auto_mode = false;
-		me->current_page = MODE_MANUAL_PAGE;
-		me->pattern = MENU_TO_PAGES[MODE_MANUAL_PAGE];
-		send_display_update(me, me->pattern, menu_settings.brightness);
-		log_message(tag, LOG_INFO, "Auto Mode: Exited");
+static bool act_next_pattern(Menu_t * const me, Menu_State_e *next) {
+	me->settings.current_pattern_index++;
+	if (me->settings.current_pattern_index >= TOTAL_PATTERNS) {
+		me->settings.current_pattern_index = 0;
 	}
-	// Note: Auto mode cycling will be handled by a separate timer task
+	me->pattern = LED_PATTERNS[me->settings.current_pattern_index];
+	return true;
 }
 
-static void handle_info(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == SINGLE_PRESS) {
-		if (event.id == BTN_1) {
-			// Next info screen (currently only firmware version)
-			// Could add more info screens here in the future
-			log_message(tag, LOG_INFO, "Info: Next screen");
-		}
-		else if (event.id == BTN_3) {
-			// Return to main menu
-			me->current_page = INFO_PAGE;
-			me->pattern = MENU_TO_PAGES[INFO_PAGE];
-			send_display_update(me, me->pattern, menu_settings.brightness);
-			log_message(tag, LOG_INFO, "Info: Returned to Main Menu");
-		}
+static bool act_auto_faster(Menu_t * const me, Menu_State_e *next) {
+	if (me->settings.auto_period_ms <= MIN_AUTO_PERIOD_MS) {
+		return false;
 	}
+	me->settings.auto_period_ms /= 2;
+	return true;
 }
 
-static void handle_reset(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == DOUBLE_PRESS && event.id == BTN_2) {
-		// Confirm reset - restore defaults
-		menu_settings.brightness = DEFAULT_BRIGHTNESS;
-		menu_settings.current_pattern_index = DEFAULT_PATTERN;
-		menu_settings.is_auto_mode = false;
-		menu_settings.saved_mode_selection = MODE_MANUAL_PAGE;
+static bool act_auto_slower(Menu_t * const me, Menu_State_e *next) {
+	if (me->settings.auto_period_ms >= MAX_AUTO_PERIOD_MS) {
+		return false;
+	}
+	me->settings.auto_period_ms *= 2;
+	return true;
+}
 
-		me->current_page = BRIGHTNESS_PAGE;
-		me->pattern = MENU_TO_PAGES[BRIGHTNESS_PAGE];
-		send_display_update(me, me->pattern, menu_settings.brightness);
+// Pattern cycling, each built-in script, then the uploaded one if any
+static bool act_next_script(Menu_t * const me, Menu_State_e *next) {
+	uint8_t scripts = LED_SCRIPT_BUILTIN_COUNT + ((me->uploaded_length != 0) ? 1 : 0);
 
-		log_message(tag, LOG_INFO, "Reset: Settings restored to defaults");
-	}
-	else if (event.type == SINGLE_PRESS && event.id == BTN_3) {
-		// Cancel reset
-		me->current_page = RESET_PAGE;
-		me->pattern = MENU_TO_PAGES[RESET_PAGE];
-		send_display_update(me, me->pattern, menu_settings.brightness);
-		log_message(tag, LOG_INFO, "Reset: Cancelled");
+	me->settings.auto_script++;
+	if (me->settings.auto_script > scripts) {
+		me->settings.auto_script = 0;
 	}
+	return true;
 }
 
-static void handle_power_off(Menu_t * const me, const BTN_event_t event) {
-	if (event.type == LONG_PRESS && event.id == BTN_1) {
-		// Restart/power on
-		menu_settings.is_powered_on = true;
-		me->current_page = BRIGHTNESS_PAGE;
-		me->pattern = MENU_TO_PAGES[BRIGHTNESS_PAGE];
-		send_display_update(me, me->pattern, menu_settings.brightness);
-		log_message(tag, LOG_INFO, "Power ON");
-	}
+// Restore defaults
+static bool act_reset(Menu_t * const me, Menu_State_e *next) {
+	me->settings.brightness = DEFAULT_BRIGHTNESS;
+	me->settings.current_pattern_index = DEFAULT_PATTERN;
+	me->settings.is_auto_mode = false;
+	me->settings.saved_mode_selection = MODE_MANUAL_PAGE;
+	me->settings.auto_period_ms = DEFAULT_AUTO_PERIOD_MS;
+	me->settings.auto_script = 0;
+	return true;
+}
+
+static const Menu_action_t MENU_ACTIONS[TOTAL_MENU_ACTS] =
+{
+	[MENU_ACT_NONE]            = { "None",            NULL,                MENU_FRAME_NONE },
+	[MENU_ACT_GOTO]            = { "Go to page",      NULL,                MENU_FRAME_PAGE },
+	[MENU_ACT_POWER_OFF]       = { "Power OFF",       NULL,                MENU_FRAME_PAGE },
+	[MENU_ACT_POWER_ON]        = { "Power ON",        NULL,                MENU_FRAME_PAGE },
+	[MENU_ACT_OPEN_MODE]       = { "Mode select",     act_open_mode,       MENU_FRAME_PAGE },
+	[MENU_ACT_SELECT_MODE]     = { "Mode toggled",    act_select_mode,     MENU_FRAME_PAGE },
+	[MENU_ACT_ENTER_MANUAL]    = { "Manual mode",     act_enter_manual,    MENU_FRAME_ACTION },
+	[MENU_ACT_ENTER_AUTO]      = { "Auto mode",       act_enter_auto,      MENU_FRAME_ACTION },
+	[MENU_ACT_EXIT_AUTO]       = { "Auto mode exit",  act_exit_auto,       MENU_FRAME_PAGE },
+	[MENU_ACT_BRIGHTNESS_UP]   = { "Brightness up",   act_brightness_up,   MENU_FRAME_ACTION },
+	[MENU_ACT_BRIGHTNESS_DOWN] = { "Brightness down", act_brightness_down, MENU_FRAME_ACTION },
+	[MENU_ACT_NEXT_PATTERN]    = { "Next pattern",    act_next_pattern,    MENU_FRAME_ACTION },
+	[MENU_ACT_AUTO_FASTER]     = { "Auto faster",     act_auto_faster,     MENU_FRAME_NONE },
+	[MENU_ACT_AUTO_SLOWER]     = { "Auto slower",     act_auto_slower,     MENU_FRAME_NONE },
+	// Drawn by Menu_script_service
+	[MENU_ACT_NEXT_SCRIPT]     = { "Auto script",     act_next_script,     MENU_FRAME_NONE },
+	// Only the firmware version so far, more info screens would go here
+	[MENU_ACT_INFO_NEXT]       = { "Info next",       NULL,                MENU_FRAME_NONE },
+	[MENU_ACT_RESET]           = { "Reset",           act_reset,           MENU_FRAME_PAGE },
+};
+
+static void save_speculation(Menu_t * const me, const BTN_event_t event) {
+	me->speculation.is_active = true;
+	me->speculation.event = event;
+	me->speculation.pattern = me->pattern;
+	me->speculation.current_page = me->current_page;
+	me->speculation.settings = me->settings;
+}
+
+static void rollback_speculation(Menu_t * const me) {
+	me->pattern = me->speculation.pattern;
+	me->current_page = me->speculation.current_page;
+	me->settings = me->speculation.settings;
+	me->speculation.is_active = false;
+
+	// Show the restored state in case the replacing event draws nothing
+	show_page(me);
+	persist_settings(me);
+	MENU_LOG(me, LOG_INFO, "Rolled back speculative BTN %d event %d",
+	            me->speculation.event.id, me->speculation.event.type);
 }
 
 void Menu_process_input(Menu_t * const me, const BTN_event_t event) {
-	// Check if powered off - only respond to BTN1 Long press
-	if (!menu_settings.is_powered_on) {
-		handle_power_off(me, event);
+	if (me->batch.is_active && me->batch.events < UINT8_MAX) {
+		me->batch.events++;
+	}
+
+	// Keep the display awake; sent ahead of any frame this event produces
+	send_display_activity(me);
+
+	if (me->speculation.is_active) {
+		if (!event.is_speculative && event.id == me->speculation.event.id
+				&& event.type == me->speculation.event.type) {
+			// Confirmed, the action is already applied
+			me->speculation.is_active = false;
+			return;
+		}
+		// Replaced by a longer gesture
+		rollback_speculation(me);
+	}
+	if (event.is_speculative) {
+		save_speculation(me, event);
+	}
+
+	// One lookup: [page][button][event]
+	uint32_t start = Port_cycles();
+	const Menu_transition_t *transition =
+			&MENU_TRANSITIONS[me->current_page][event.id][event.type];
+	const Menu_action_t *action = &MENU_ACTIONS[transition->action];
+	Menu_State_e from = me->current_page;
+	Menu_State_e next = (Menu_State_e) transition->next;
+
+	bool is_done = (transition->action != MENU_ACT_NONE)
+			&& (action->run == NULL || action->run(me, &next));
+	if (is_done) {
+		if (action->frame == MENU_FRAME_PAGE) {
+			change_page(me, next);
+		} else {
+			me->current_page = next;
+		}
+	}
+
+	uint32_t cycles = Port_cycles() - start;
+	Menu_dispatch_stats_t *stats = &me->dispatch_stats;
+	stats->dispatches++;
+	stats->last_cycles = cycles;
+	stats->total_cycles += cycles;
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+
+	if (!is_done) {
 		return;
 	}
+	if (action->frame != MENU_FRAME_NONE) {
+		show_page(me);
+	}
+	persist_settings(me);
+	MENU_LOG(me, LOG_INFO, "%s: page %d -> %d", action->name, from, me->current_page);
+}
+
+void Menu_begin_batch(Menu_t * const me) {
+	me->batch = (Menu_batch_t ) { 0 };
+	me->batch.is_active = true;
+}
 
-	// Route to appropriate handler based on current page
-	switch(me->current_page) {
-		case BRIGHTNESS_PAGE:
-		case MODE_SELECT_PAGE:
-		case INFO_PAGE:
-		case RESET_PAGE:
-			handle_main_menu(me, event);
-			break;
+void Menu_end_batch(Menu_t * const me) {
+	Menu_batch_t *batch = &me->batch;
+	Menu_batch_stats_t *stats = &me->batch_stats;
 
-		case BRIGHTNESS_SETTING:
-			handle_brightness_setting(me, event);
-			break;
+	batch->is_active = false;
+	if (batch->events > 1) {
+		stats->batches++;
+		stats->events += batch->events;
+		if (batch->events > stats->max_events) {
+			stats->max_events = batch->events;
+		}
+	}
+
+	// Activity goes first, as it would ahead of the frame of a single event
+	if (batch->is_activity_pending) {
+		send_display_activity(me);
+	}
+	if (batch->is_frame_pending) {
+		send_display_update(me, batch->pattern, batch->brightness);
+	}
+	log_message(tag, LOG_INFO, "Batch: %u events, page %d, %lu frames and %lu log lines skipped so far",
+	            batch->events, me->current_page, stats->frames_skipped, stats->logs_skipped);
+}
 
-		case MODE_MANUAL_PAGE:
-		case MODE_AUTO_PAGE:
-			handle_mode_select(me, event);
-			break;
+void Menu_get_batch_stats(const Menu_t * const me, Menu_batch_stats_t *out) {
+	*out = me->batch_stats;
+}
 
-		case MANUAL_MODE:
-			handle_manual_mode(me, event);
-			break;
+void Menu_get_dispatch_stats(const Menu_t * const me, Menu_dispatch_stats_t *out) {
+	*out = me->dispatch_stats;
+}
 
-		case AUTO_MODE:
-			handle_auto_mode(me, event);
-			break;
+static uint32_t page_events(Menu_State_e page) {
+	uint32_t events = 0;
 
-		case FIRMWARE_VER:
-			handle_info(me, event);
-			break;
+	for (uint8_t id = 0; id < TOTAL_BTNS; id++) {
+		for (uint8_t type = 0; type < TOTAL_BTN_EVENTS; type++) {
+			if (MENU_TRANSITIONS[page][id][type].action != MENU_ACT_NONE) {
+				events |= BTN_EVENT_BIT(id, type);
+			}
+		}
+	}
+	return events;
+}
 
-		case RESET_CONFIRM:
-			handle_reset(me, event);
-			break;
+// Every event with a transition on the current page; anything longer than a
+// single press that a page ignores is not waited for by the button layer.
+// A speculative press may already have left the page it was applied on, so
+// that page's events stay accepted until the press is confirmed or rolled
+// back, or the longer gesture it stands in for would never be waited for.
+uint32_t Menu_accepted_events(const Menu_t * const me) {
+	uint32_t events = page_events(me->current_page);
 
-		default:
-			log_message(tag, LOG_WARN, "Unknown page state: %d", me->current_page);
-			break;
+	if (me->speculation.is_active) {
+		events |= page_events(me->speculation.current_page);
 	}
+	return events;
+}
+
+bool Menu_is_powered_off(const Menu_t * const me) {
+	return me->current_page == POWER_OFF;
 }
 
 // Additional helper function to get current auto mode state
-bool Menu_is_auto_mode_active(void) {
-	return menu_settings.is_auto_mode;
+bool Menu_is_auto_mode_active(const Menu_t * const me) {
+	return me->settings.is_auto_mode;
+}
+
+uint16_t Menu_auto_cycle_period_ms(const Menu_t * const me) {
+	return me->settings.auto_period_ms;
 }
 
 // Helper function to cycle pattern in auto mode
 void Menu_auto_cycle_pattern(Menu_t * const me) {
-	if (menu_settings.is_auto_mode && me->current_page == AUTO_MODE) {
-		menu_settings.current_pattern_index++;
-		if (menu_settings.current_pattern_index >= TOTAL_PATTERNS) {
-			menu_settings.current_pattern_index = 0;
+	if (me->settings.is_auto_mode && me->current_page == AUTO_MODE && me->settings.auto_script == 0) {
+		me->settings.current_pattern_index++;
+		if (me->settings.current_pattern_index >= TOTAL_PATTERNS) {
+			me->settings.current_pattern_index = 0;
+		}
+		me->pattern = LED_PATTERNS[me->settings.current_pattern_index];
+		send_display_update(me, me->pattern, me->settings.brightness);
+	}
+}
+
+bool Menu_is_script_playing(const Menu_t * const me) {
+	return me->settings.is_auto_mode && me->settings.auto_script != 0;
+}
+
+// Script the interpreter should be running, 0 for none
+static uint8_t wanted_script(const Menu_t * const me) {
+	if (me->current_page != AUTO_MODE || !me->settings.is_auto_mode) {
+		return 0;
+	}
+	return me->settings.auto_script;
+}
+
+static bool load_script(Menu_t * const me, uint8_t script) {
+	const char *name = "Uploaded";
+	const uint8_t *code = me->uploaded;
+	uint16_t length = me->uploaded_length;
+
+	if (script <= LED_SCRIPT_BUILTIN_COUNT) {
+		name = LED_SCRIPT_BUILTINS[script - 1].name;
+		code = LED_SCRIPT_BUILTINS[script - 1].code;
+		length = LED_SCRIPT_BUILTINS[script - 1].length;
+	}
+	if (!LedScript_load(&me->script, code, length, me->settings.brightness, Port_now_us())) {
+		return false;
+	}
+	MENU_LOG(me, LOG_INFO, "Auto mode script: %s, %u bytes", name, length);
+	return true;
+}
+
+void Menu_script_service(Menu_t * const me, uint32_t now) {
+	uint8_t wanted = wanted_script(me);
+
+	if (wanted != me->script_loaded) {
+		me->script_loaded = 0;
+		if (wanted == 0) {
+			// Back to pattern cycling, or auto mode was left and has drawn its page
+			if (me->current_page == AUTO_MODE) {
+				me->pattern = LED_PATTERNS[me->settings.current_pattern_index];
+				show_page(me);
+			}
+			return;
+		}
+		if (!load_script(me, wanted)) {
+			me->settings.auto_script = 0; // Gone, e.g. never uploaded
+			return;
 		}
-		me->pattern = LED_PATTERNS[menu_settings.current_pattern_index];
-		send_display_update(me, me->pattern, menu_settings.brightness);
+		me->script_loaded = wanted;
+		me->script_due = now;
+	}
+	if (me->script_loaded == 0 || me->script.is_stopped
+			|| (int32_t) (now - me->script_due) < 0) {
+		return;
+	}
+
+	LedScript_status_e status = LedScript_step(&me->script);
+	if (status == LED_SCRIPT_FAULT) {
+		log_message(tag, LOG_WARN, "Auto mode script stopped at %u, stack fault", me->script.pc);
+	}
+
+	// A step without a WAIT still takes one unit, so a looping program cannot
+	// keep this task busy; waits follow the auto mode speed
+	uint16_t wait_ms = (status == LED_SCRIPT_WAIT) ? me->script.wait_ms : 0;
+	if (wait_ms < LED_SCRIPT_WAIT_UNIT_MS) {
+		wait_ms = LED_SCRIPT_WAIT_UNIT_MS;
+	}
+	uint32_t delay = (uint32_t) wait_ms * me->settings.auto_period_ms / DEFAULT_AUTO_PERIOD_MS;
+	me->script_due += delay;
+	if ((int32_t) (now - me->script_due) >= 0) {
+		me->script_due = now + delay; // Fell behind, the missed frames are dropped
+	}
+
+	me->pattern = me->script.pattern;
+	send_display_update(me, me->script.pattern, me->script.brightness);
+}
+
+uint32_t Menu_script_next_deadline_ms(const Menu_t * const me, uint32_t now) {
+	if (wanted_script(me) != me->script_loaded) {
+		return 0;
+	}
+	if (me->script_loaded == 0 || me->script.is_stopped) {
+		return PORT_WAIT_FOREVER;
+	}
+	int32_t left = (int32_t) (me->script_due - now);
+	return (left > 0) ? (uint32_t) left : 0;
+}
+
+bool Menu_upload_script(Menu_t * const me, const uint8_t *code, uint16_t length) {
+	if (!LedScript_verify(code, length)) {
+		log_message(tag, LOG_WARN, "Uploaded script rejected, %u bytes", length);
+		return false;
+	}
+	memcpy(me->uploaded, code, length);
+	me->uploaded_length = length;
+	if (me->script_loaded > LED_SCRIPT_BUILTIN_COUNT) {
+		me->script_loaded = 0; // Playing the old upload, restart with the new one
 	}
+	log_message(tag, LOG_INFO, "Script uploaded, %u bytes", length);
+	return true;
 }
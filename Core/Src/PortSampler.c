@@ -0,0 +1,49 @@
+/*
+ * PortSampler.c
+ *
+ *  Created on: 21-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "PortSampler.h"
+
+void PortSampler_ctor(PortSampler_t *const me, TIM_HandleTypeDef *htim,
+		GPIO_TypeDef *port, volatile uint16_t *buffer, uint16_t length) {
+	me->htim = htim;
+	me->port = port;
+	me->buffer = buffer;
+	me->length = length;
+	me->read_index = 0;
+}
+
+bool PortSampler_start(PortSampler_t *const me) {
+	DMA_HandleTypeDef *hdma = me->htim->hdma[TIM_DMA_ID_UPDATE];
+
+	// Polled transfer: no DMA interrupts, the reader follows NDTR instead
+	if (HAL_DMA_Start(hdma, (uint32_t) &me->port->IDR, (uint32_t) me->buffer,
+			me->length) != HAL_OK) {
+		return false;
+	}
+	me->read_index = 0;
+
+	__HAL_TIM_ENABLE_DMA(me->htim, TIM_DMA_UPDATE);
+	return HAL_TIM_Base_Start(me->htim) == HAL_OK;
+}
+
+uint16_t PortSampler_read(PortSampler_t *const me, uint16_t *out, uint16_t max) {
+	// NDTR counts down from length and reloads on wrap
+	uint16_t write_index = me->length
+			- (uint16_t) __HAL_DMA_GET_COUNTER(me->htim->hdma[TIM_DMA_ID_UPDATE]);
+	if (write_index >= me->length) {
+		write_index = 0;
+	}
+
+	uint16_t count = 0;
+	while (me->read_index != write_index && count < max) {
+		out[count++] = me->buffer[me->read_index];
+		if (++me->read_index == me->length) {
+			me->read_index = 0;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,77 @@
+/*
+ * SN74HC165.c
+ *
+ *  Created on: 24-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "SN74HC165.h"
+#include "debug_logger.h"
+
+static char *const tag = "SR165";
+
+static void init_pin(GPIO_TypeDef *port, uint16_t pin, uint32_t mode,
+		uint32_t pull) {
+	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+	GPIO_InitStruct.Pin = pin;
+	GPIO_InitStruct.Mode = mode;
+	GPIO_InitStruct.Pull = pull;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+	HAL_GPIO_Init(port, &GPIO_InitStruct);
+}
+
+void SN74HC165_ctor(SN74HC165_t *const me, GPIO_TypeDef *load_port,
+		uint16_t load_pin, GPIO_TypeDef *clk_port, uint16_t clk_pin,
+		GPIO_TypeDef *data_port, uint16_t data_pin, uint8_t chip_count) {
+
+	me->load_port = load_port;
+	me->load_pin = load_pin;
+	me->clk_port = clk_port;
+	me->clk_pin = clk_pin;
+	me->data_port = data_port;
+	me->data_pin = data_pin;
+	me->chip_count = (chip_count < SN74HC165_MAX_CHIPS) ?
+			chip_count : SN74HC165_MAX_CHIPS;
+
+	// Idle with the register shifting and the clock low
+	HAL_GPIO_WritePin(me->load_port, me->load_pin, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(me->clk_port, me->clk_pin, GPIO_PIN_RESET);
+	init_pin(me->load_port, me->load_pin, GPIO_MODE_OUTPUT_PP, GPIO_NOPULL);
+	init_pin(me->clk_port, me->clk_pin, GPIO_MODE_OUTPUT_PP, GPIO_NOPULL);
+	init_pin(me->data_port, me->data_pin, GPIO_MODE_INPUT, GPIO_NOPULL);
+
+	log_message(tag, LOG_INFO, "SN74HC165 initialized - %d chips, %d inputs",
+			me->chip_count, me->chip_count * 8);
+}
+
+void SN74HC165_read(void *ctx, uint32_t *words) {
+	SN74HC165_t *const me = ctx;
+
+	for (int w = 0; w < INPUT_SCAN_WORDS; w++) {
+		words[w] = 0xFFFFFFFFU; // Missing inputs read as released
+	}
+
+	// Pulse SH/LD low to capture every parallel input at once
+	HAL_GPIO_WritePin(me->load_port, me->load_pin, GPIO_PIN_RESET);
+	__NOP();
+	__NOP();
+	HAL_GPIO_WritePin(me->load_port, me->load_pin, GPIO_PIN_SET);
+
+	// QH shows chip 0 D7 first, then D6..D0, then chip 1 D7...
+	for (uint8_t chip = 0; chip < me->chip_count; chip++) {
+		uint32_t byte = 0;
+		for (int bit = 7; bit >= 0; bit--) {
+			if (HAL_GPIO_ReadPin(me->data_port, me->data_pin) == GPIO_PIN_SET) {
+				byte |= 1U << bit;
+			}
+			// Rising edge moves the next bit to QH
+			HAL_GPIO_WritePin(me->clk_port, me->clk_pin, GPIO_PIN_SET);
+			__NOP();
+			__NOP();
+			HAL_GPIO_WritePin(me->clk_port, me->clk_pin, GPIO_PIN_RESET);
+		}
+
+		uint32_t shift = (chip % 4) * 8;
+		words[chip / 4] = (words[chip / 4] & ~(0xFFU << shift)) | (byte << shift);
+	}
+}
@@ -7,6 +7,7 @@
 
 #include "SN74HC595.h"
 #include "debug_logger.h"
+#include "Clock.h"
 
 #define MAX_BRIGHTNESS 10
 #define MIN_BRIGHTNESS 0
@@ -55,6 +56,7 @@ void SN74HC595_ctor(SN74HC595_t *const me, GPIO_TypeDef *data_port,
 	// Initialize state
 	me->current_data = 0x0000;
 	me->current_brightness = 5; // Default medium brightness
+	me->last_latch_time = 0;
 
 	// Initialize GPIO states
 	HAL_GPIO_WritePin(me->ser_data_port, me->ser_data_pin, GPIO_PIN_RESET);
@@ -97,11 +99,14 @@ void SN74HC595_write(SN74HC595_t *const me, uint16_t data) {
 
 	// Pulse RCLK to latch the data to output registers
 	pulse_latch(me->rclk_port, me->rclk_pin);
+	me->last_latch_time = Clock_now_us();
 
 	log_message(tag, LOG_DEBUG, "Wrote data: 0x%04X", data);
 }
 
-void SN74HC595_set_brightness(SN74HC595_t *const me, uint8_t brightness) {
+// Program the OE duty cycle for a brightness level, without logging;
+// returns the duty cycle
+static uint32_t apply_brightness(SN74HC595_t *const me, uint8_t brightness) {
 	// Clamp brightness to valid range
 	if (brightness > MAX_BRIGHTNESS) {
 		brightness = MAX_BRIGHTNESS;
@@ -133,13 +138,20 @@ void SN74HC595_set_brightness(SN74HC595_t *const me, uint8_t brightness) {
 	// Set PWM duty cycle on the configured channel
 	__HAL_TIM_SET_COMPARE(me->htim, me->tim_channel, duty_cycle);
 
+	return duty_cycle;
+}
+
+void SN74HC595_set_brightness(SN74HC595_t *const me, uint8_t brightness) {
+	uint32_t duty_cycle = apply_brightness(me, brightness);
+
 	log_message(tag, LOG_DEBUG, "Brightness set to %d (PWM duty: %lu%%)",
-			brightness, (duty_cycle * 100) / PWM_PERIOD);
+			me->current_brightness, (duty_cycle * 100) / PWM_PERIOD);
 }
 
 void SN74HC595_update(SN74HC595_t *const me, uint16_t data, uint8_t brightness) {
-	// Update brightness first (affects display immediately)
-	SN74HC595_set_brightness(me, brightness);
+	// Update brightness first (affects display immediately); logged after
+	// the latch so the frame is not held up by the UART
+	apply_brightness(me, brightness);
 
 	// Then update data pattern
 	SN74HC595_write(me, data);
@@ -180,3 +192,26 @@ void SN74HC595_enable_output(SN74HC595_t *const me) {
 			me->current_brightness);
 }
 
+void SN74HC595_stop_pwm(SN74HC595_t *const me) {
+	// Park the compare above ARR so the PWM output stays HIGH (OE inactive).
+	// The compare register is preloaded, so force an update to apply it now.
+	__HAL_TIM_SET_COMPARE(me->htim, me->tim_channel, PWM_PERIOD);
+	me->htim->Instance->EGR = TIM_EGR_UG;
+
+	// Freeze the counter; the output holds its last (HIGH) level.
+	// __HAL_TIM_DISABLE refuses while a channel is enabled, so clear CEN here.
+	me->htim->Instance->CR1 &= ~TIM_CR1_CEN;
+
+	log_message(tag, LOG_DEBUG, "PWM stopped");
+}
+
+void SN74HC595_start_pwm(SN74HC595_t *const me) {
+	__HAL_TIM_ENABLE(me->htim);
+
+	log_message(tag, LOG_DEBUG, "PWM started");
+}
+
+void SN74HC595_wake(SN74HC595_t *const me, uint8_t brightness) {
+	__HAL_TIM_ENABLE(me->htim);
+	apply_brightness(me, brightness);
+}
@@ -0,0 +1,123 @@
+/*
+ * ScanKeys.c
+ *
+ *  Created on: 03-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "ScanKeys.h"
+#include "Clock.h"
+#include "debug_logger.h"
+
+static char *const tag = "ScanKeys";
+
+void ScanKeys_ctor(ScanKeys_t *const me, uint16_t first, uint16_t inputs,
+		EventRing_t *ring) {
+	if (inputs > INPUT_SCAN_MAX_INPUTS) {
+		inputs = INPUT_SCAN_MAX_INPUTS;
+	}
+	for (uint8_t w = 0; w < INPUT_SCAN_WORDS; w++) {
+		me->mask[w] = 0;
+		// Released (1) to start with, the polarity of the chain
+		Debounce_ctor(&me->debounce[w], 0xFFFFFFFFUL, SCAN_KEYS_DEBOUNCE_SAMPLES);
+	}
+	for (uint16_t n = first; n < inputs; n++) {
+		me->mask[n / 32] |= 1UL << (n % 32);
+	}
+	me->ring = ring;
+	me->consumer = NULL;
+	me->consumer_flag = 0;
+	me->stats = (ScanKeys_stats_t ) { 0 };
+}
+
+void ScanKeys_set_consumer(ScanKeys_t *const me, osThreadId_t thread,
+		uint32_t flag) {
+	me->consumer_flag = flag;
+	me->consumer = thread;
+}
+
+void ScanKeys_process(ScanKeys_t *const me, const uint32_t *words,
+		uint32_t now) {
+	uint32_t start = DWT->CYCCNT;
+	bool is_sent = false;
+
+	for (uint8_t w = 0; w < INPUT_SCAN_WORDS; w++) {
+		if (me->mask[w] == 0) {
+			continue;
+		}
+		// Inputs not owned read as released, so they never change
+		uint32_t changed = Debounce_update(&me->debounce[w], words[w] | ~me->mask[w]);
+
+		while (changed != 0 && me->ring != NULL) {
+			uint32_t bit = (uint32_t) __builtin_ctz(changed);
+			changed &= changed - 1U;
+
+			bool is_pressed = (me->debounce[w].state & (1UL << bit)) == 0;
+			uint32_t packed = (w * 32U + bit) | ((is_pressed ? 1UL : 0UL) << 7)
+					| ((now & SCAN_KEYS_PACKED_TIME_MASK) << SCAN_KEYS_PACKED_TIME_SHIFT);
+			if (EventRing_put(me->ring, packed)) {
+				me->stats.edges++;
+				is_sent = true;
+			} else {
+				me->stats.dropped++;
+			}
+		}
+	}
+
+	if (is_sent && me->consumer != NULL) {
+		osThreadFlagsSet(me->consumer, me->consumer_flag);
+	}
+
+	uint32_t cycles = DWT->CYCCNT - start;
+	me->stats.scans++;
+	me->stats.last_cycles = cycles;
+	if (cycles > me->stats.max_cycles) {
+		me->stats.max_cycles = cycles;
+	}
+}
+
+bool ScanKeys_receive(ScanKeys_t *const me, ScanKeys_event_t *event) {
+	uint32_t packed;
+
+	if (me->ring == NULL || !EventRing_get(me->ring, &packed)) {
+		return false;
+	}
+	uint32_t now = Clock_now_us();
+	uint32_t age = (now - (packed >> SCAN_KEYS_PACKED_TIME_SHIFT)) & SCAN_KEYS_PACKED_TIME_MASK;
+	event->key = (uint8_t) (packed & 0x7FU);
+	event->is_pressed = (packed & 0x80U) != 0;
+	event->timestamp = now - age;
+	return true;
+}
+
+void ScanKeys_pressed(const ScanKeys_t *const me, uint32_t *words) {
+	for (uint8_t w = 0; w < INPUT_SCAN_WORDS; w++) {
+		words[w] = ~me->debounce[w].state & me->mask[w];
+	}
+}
+
+void ScanKeys_benchmark(ScanKeys_t *const me, uint16_t runs) {
+	uint32_t released[INPUT_SCAN_WORDS];
+	ScanKeys_stats_t saved = me->stats;
+	uint16_t inputs = 0;
+
+	if (runs == 0) {
+		return;
+	}
+	for (uint8_t w = 0; w < INPUT_SCAN_WORDS; w++) {
+		released[w] = 0xFFFFFFFFUL;
+		inputs += (uint16_t) __builtin_popcount(me->mask[w]);
+	}
+
+	uint32_t total = 0;
+	me->stats = (ScanKeys_stats_t ) { 0 };
+	for (uint16_t i = 0; i < runs; i++) {
+		ScanKeys_process(me, released, 0);
+		total += me->stats.last_cycles;
+	}
+	log_message(tag, LOG_INFO, "%u keys: %lu cycles/scan to debounce and queue, max %lu",
+			inputs, total / runs, me->stats.max_cycles);
+
+	// Benchmark scans are not part of the running statistics
+	me->stats = saved;
+}
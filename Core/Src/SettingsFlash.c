@@ -0,0 +1,74 @@
+/*
+ * SettingsFlash.c
+ *
+ *  Created on: 29-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "SettingsFlash.h"
+#include "debug_logger.h"
+
+static char *const tag = "SettingsFlash";
+
+static const uint32_t sectors[SETTINGS_STORE_BANKS] = {
+	SETTINGS_FLASH_SECTOR_0, SETTINGS_FLASH_SECTOR_1
+};
+static const uint32_t addresses[SETTINGS_STORE_BANKS] = {
+	SETTINGS_FLASH_ADDRESS_0, SETTINGS_FLASH_ADDRESS_1
+};
+
+static void clear_errors(void) {
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR
+			| FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+}
+
+static bool erase(void *ctx, uint8_t bank) {
+	FLASH_EraseInitTypeDef erase_init = { 0 };
+	uint32_t sector_error = 0;
+
+	erase_init.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase_init.Sector = sectors[bank];
+	erase_init.NbSectors = 1;
+	erase_init.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+	uint32_t start = DWT->CYCCNT;
+	HAL_FLASH_Unlock();
+	clear_errors();
+	HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase_init, &sector_error);
+	HAL_FLASH_Lock();
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	log_message(tag, (status == HAL_OK) ? LOG_INFO : LOG_ERROR,
+			"Sector %lu erase %s in %lu ms", sectors[bank],
+			(status == HAL_OK) ? "done" : "failed",
+			cycles / (SystemCoreClock / 1000U));
+	return status == HAL_OK;
+}
+
+static bool program(void *ctx, uint8_t bank, uint32_t offset,
+		const uint32_t *words, uint32_t count) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	HAL_FLASH_Unlock();
+	clear_errors();
+	for (uint32_t i = 0; i < count && status == HAL_OK; i++) {
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,
+				addresses[bank] + offset + i * sizeof(uint32_t), words[i]);
+	}
+	HAL_FLASH_Lock();
+
+	if (status != HAL_OK) {
+		log_message(tag, LOG_ERROR, "Program at 0x%08lx failed",
+				addresses[bank] + offset);
+	}
+	return status == HAL_OK;
+}
+
+void SettingsFlash_ctor(SettingsStore_flash_t *flash) {
+	flash->base[0] = (const uint8_t*) SETTINGS_FLASH_ADDRESS_0;
+	flash->base[1] = (const uint8_t*) SETTINGS_FLASH_ADDRESS_1;
+	flash->size = SETTINGS_FLASH_SIZE;
+	flash->erase = erase;
+	flash->program = program;
+	flash->ctx = NULL;
+}
@@ -0,0 +1,228 @@
+/*
+ * SettingsStore.c
+ *
+ *  Created on: 29-Jan-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "SettingsStore.h"
+#include <string.h>
+
+#define RECORD_SIZE   sizeof(SettingsStore_record_t)
+#define RECORD_WORDS  (RECORD_SIZE / sizeof(uint32_t))
+#define CRC_SPAN      (RECORD_SIZE - sizeof(uint32_t))
+
+// A torn record makes the mount step back; more than this many in a row
+// means the region is not ours
+#define MAX_TORN_RECORDS 4
+
+// CRC-32 (IEEE), a nibble at a time
+static uint32_t crc32(const uint8_t *bytes, uint32_t length) {
+	static const uint32_t table[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+		0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+		0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+	};
+	uint32_t crc = 0xFFFFFFFFUL;
+
+	for (uint32_t i = 0; i < length; i++) {
+		crc ^= bytes[i];
+		crc = (crc >> 4) ^ table[crc & 0x0F];
+		crc = (crc >> 4) ^ table[crc & 0x0F];
+	}
+	return ~crc;
+}
+
+static const SettingsStore_record_t *record_at(const SettingsStore_t *const me,
+		uint8_t bank, uint32_t index) {
+	return (const SettingsStore_record_t*) (me->flash->base[bank] + index * RECORD_SIZE);
+}
+
+static bool is_blank(const SettingsStore_record_t *record) {
+	const uint32_t *words = (const uint32_t*) record;
+	for (uint32_t i = 0; i < RECORD_WORDS; i++) {
+		if (words[i] != 0xFFFFFFFFUL) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool is_valid(const SettingsStore_record_t *record) {
+	return record->magic == SETTINGS_STORE_MAGIC
+			&& record->crc == crc32((const uint8_t*) record, CRC_SPAN);
+}
+
+// Finds a bank's first free record and its latest valid one (NULL if none)
+static const SettingsStore_record_t *mount_bank(SettingsStore_t *const me,
+		uint8_t bank, uint32_t *next) {
+	uint32_t count = me->flash->size / RECORD_SIZE;
+
+	// Records are only ever appended, so the used ones come first and the
+	// first blank one is found by bisection
+	uint32_t low = 0;
+	uint32_t high = count;
+	while (low < high) {
+		uint32_t mid = low + (high - low) / 2;
+		me->stats.probes++;
+		if (is_blank(record_at(me, bank, mid))) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+	*next = low * RECORD_SIZE;
+
+	for (uint32_t i = low; i > 0 && low - i < MAX_TORN_RECORDS; i--) {
+		const SettingsStore_record_t *record = record_at(me, bank, i - 1);
+		me->stats.probes++;
+		if (is_valid(record)) {
+			return record;
+		}
+	}
+	return NULL;
+}
+
+void SettingsStore_ctor(SettingsStore_t *const me,
+		const SettingsStore_flash_t *flash) {
+	const SettingsStore_record_t *latest = NULL;
+
+	me->flash = flash;
+	me->bank = 0;
+	me->next = 0;
+	me->is_pending = false;
+	me->is_changed = false;
+	me->changed_time = 0;
+	memset(me->current, 0, sizeof(me->current));
+	memset(me->pending, 0, sizeof(me->pending));
+	me->stats = (SettingsStore_stats_t ) { 0 };
+
+	// The bank switched to last holds the current settings. A reset while it
+	// was being started leaves it torn, and the other bank still counts.
+	for (uint8_t bank = 0; bank < SETTINGS_STORE_BANKS; bank++) {
+		uint32_t next;
+		const SettingsStore_record_t *record = mount_bank(me, bank, &next);
+		if (bank == 0 || (record != NULL && (latest == NULL
+				|| (int16_t) (record->erases - latest->erases) > 0))) {
+			latest = record;
+			me->bank = bank;
+			me->next = next;
+		}
+	}
+
+	if (latest != NULL) {
+		memcpy(me->current, latest->data, sizeof(me->current));
+		me->stats.erases = latest->erases;
+		me->stats.is_restored = true;
+	}
+}
+
+bool SettingsStore_load(const SettingsStore_t *const me, uint8_t *data) {
+	if (!me->stats.is_restored) {
+		return false;
+	}
+	memcpy(data, me->current, sizeof(me->current));
+	return true;
+}
+
+void SettingsStore_save(SettingsStore_t *const me, const uint8_t *data) {
+	if (me->is_pending) {
+		if (memcmp(data, me->pending, sizeof(me->pending)) == 0) {
+			return;
+		}
+		me->stats.coalesced++;
+	}
+
+	// Back to what flash holds, nothing left to write
+	if (memcmp(data, me->current, sizeof(me->current)) == 0
+			&& me->stats.is_restored) {
+		me->is_pending = false;
+		return;
+	}
+	memcpy(me->pending, data, sizeof(me->pending));
+	me->is_pending = true;
+	me->is_changed = true;
+}
+
+static bool append(SettingsStore_t *const me) {
+	const SettingsStore_flash_t *flash = me->flash;
+	SettingsStore_record_t record;
+
+	// Full: erase the other bank and start it with the new record, which
+	// holds everything. The full bank keeps the latest settings until that
+	// record is complete, so a reset during the erase (1-2 s on the F411)
+	// or the program loses nothing. The record is retried in the same
+	// bank, already erased, if the program fails.
+	if (me->next + RECORD_SIZE > flash->size) {
+		uint8_t other = me->bank ^ 1U;
+		if (!flash->erase(flash->ctx, other)) {
+			me->stats.failures++;
+			return false;
+		}
+		me->bank = other;
+		me->next = 0;
+		me->stats.erases++;
+	}
+
+	record.magic = SETTINGS_STORE_MAGIC;
+	record.erases = me->stats.erases;
+	memcpy(record.data, me->pending, sizeof(record.data));
+	record.crc = crc32((const uint8_t*) &record, CRC_SPAN);
+
+	const SettingsStore_record_t *slot = record_at(me, me->bank, me->next / RECORD_SIZE);
+	bool is_programmed = flash->program(flash->ctx, me->bank, me->next,
+			(const uint32_t*) &record, RECORD_WORDS);
+	// A half-programmed record is skipped (the mount steps back over it),
+	// but a blank one must stay in place to keep the used records together
+	if (!is_blank(slot)) {
+		me->next += RECORD_SIZE;
+	}
+	if (!is_programmed) {
+		me->stats.failures++;
+		return false;
+	}
+
+	memcpy(me->current, me->pending, sizeof(me->current));
+	me->stats.is_restored = true;
+	me->stats.writes++;
+	me->is_pending = false;
+	return true;
+}
+
+bool SettingsStore_service(SettingsStore_t *const me, uint32_t now) {
+	if (me->is_changed) {
+		me->is_changed = false;
+		me->changed_time = now;
+	}
+	if (!me->is_pending || now - me->changed_time < SETTINGS_STORE_IDLE_MS) {
+		return false;
+	}
+	if (!append(me)) {
+		me->changed_time = now; // Retry after another idle period
+		return false;
+	}
+	return true;
+}
+
+bool SettingsStore_flush(SettingsStore_t *const me) {
+	me->is_changed = false;
+	return me->is_pending && append(me);
+}
+
+uint32_t SettingsStore_next_deadline_ms(const SettingsStore_t *const me,
+		uint32_t now) {
+	if (!me->is_pending) {
+		return SETTINGS_STORE_NO_DEADLINE;
+	}
+	if (me->is_changed) {
+		return SETTINGS_STORE_IDLE_MS;
+	}
+	uint32_t idle = now - me->changed_time;
+	return (idle < SETTINGS_STORE_IDLE_MS) ? SETTINGS_STORE_IDLE_MS - idle : 0;
+}
+
+void SettingsStore_get_stats(const SettingsStore_t *const me,
+		SettingsStore_stats_t *out) {
+	*out = me->stats;
+}
@@ -11,6 +11,7 @@
 
 #include "main.h"
 #include "debug_logger.h"
+#include "Clock.h"
 
 #define USE_FULL_ASSERT
 #ifdef __GNUC__
@@ -72,11 +73,11 @@ void get_current_time(char *buffer, size_t size) {
 	if (buffer == NULL || size < 8)
 		return;  // Safety check
 
-	uint32_t time_ms = HAL_GetTick();
-	uint32_t seconds = time_ms / 1000;
-	uint32_t millis = time_ms % 1000;
+	uint64_t time_us = Clock_now_us64();
+	uint32_t seconds = (uint32_t) (time_us / 1000000U);
+	uint32_t micros = (uint32_t) (time_us % 1000000U);
 
-	snprintf(buffer, size - 1, "%lu.%03lu", seconds, millis);
+	snprintf(buffer, size - 1, "%lu.%06lu", seconds, micros);
 	buffer[size - 1] = '\0';  // Null-terminate for safety
 }
 
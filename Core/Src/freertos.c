@@ -27,30 +27,199 @@
 /* USER CODE BEGIN Includes */
 #include "Display.h"
 #include "Button.h"
+#include "Gesture.h"
 #include "Menu.h"
+#include "PortSampler.h"
+#include "SN74HC165.h"
+#include "KeyMatrix.h"
+#include "ScanKeys.h"
+#include "Clock.h"
+#include "SettingsFlash.h"
+#include "LowPower.h"
+#include "freertos_mpool.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
+typedef StaticQueue_t osStaticMessageQDef_t;
 /* USER CODE BEGIN PTD */
 
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-#define AUTO_CYCLE_PERIOD_MS	2000
+#define DISPLAY_FRAME_RATE_HZ	0	// 0 = render on arrival, else 100/500/1000 Hz pacing
+#define DISPLAY_MSG_POOL_BLOCKS	16	// Display messages in flight, matches the queue depth
+#define DISPLAY_IDLE_DIM_MS	30000	// No button input for this long dims the display (0 = never)
+#define DISPLAY_DIM_STEP_MS	100		// Ramp speed, per brightness level, before blanking
+
+// Gesture timing
+#define SINGLE_WINDOW		300	// Pause that ends a click sequence
+#define DOUBLE_WINDOW		500	// Second click must land within this of the first
+#define TRIPLE_WINDOW		700	// Third click must land within this of the first
+#define TRIPLE_GAP			200	// Pause that settles a double press
+
+// Hold-to-repeat (brightness and manual pattern pages)
+#define REPEAT_DELAY_MS		400	// Hold before the first REPEAT
+#define REPEAT_START_MS		200	// First interval
+#define REPEAT_MIN_MS		40	// Fastest interval
+#define REPEAT_STEP_PERCENT	80	// Each interval relative to the previous one
+
+#define BUTTON_DMA_SAMPLES	64	// Sample ring, 64 ms of history at 1 kHz
+#define BUTTON_BATCH_MS		8	// ButtonInputTask wake period in DMA mode
+
+#define BUTTON_USE_DMA	(!BUTTON_USE_EXTI && BUTTON_SOURCE == BUTTON_SOURCE_PORT_DMA)
+#define BUTTON_USE_SCAN	(!BUTTON_USE_EXTI && BUTTON_SOURCE != BUTTON_SOURCE_PORT_DMA)
+
+// Scanned input chains, the gesture buttons are their first inputs. The
+// pins are free on the Black Pill and configured by the drivers.
+#define SCAN_SHIFT_IN_CHIPS	2		// 74HC165s in the chain, 8 inputs each (up to 8)
+#define SCAN_MATRIX_COL_FIRST	8	// Columns on PA8..PA11
+#define SCAN_MATRIX_COLS	4
+#define SCAN_MATRIX_SETTLE_CYCLES	100	// 1 us at 100 MHz after selecting a row
+#define SCAN_BENCHMARK_RUNS	64		// Scans timed at startup
+#define SCAN_KEY_RING_SIZE	16		// Raw edges of the inputs past the gesture buttons
+#if BUTTON_SOURCE == BUTTON_SOURCE_SHIFT_IN
+#define SCAN_INPUTS	(SCAN_SHIFT_IN_CHIPS * 8)
+#else
+#define SCAN_INPUTS	((sizeof(button_matrix_rows) / sizeof(button_matrix_rows[0])) * SCAN_MATRIX_COLS)
+#endif
+
+// Packed button event rings, sizes must be powers of two
+#define BUTTON_NAV_RING_SIZE		16
+#define BUTTON_CONTROL_RING_SIZE	4
+#define BUTTON_DELIVERY_BENCHMARK_RUNS	64	// Event round trips timed at startup
+// Most events MenuLogicTask applies as one batch, everything both rings hold
+#define MENU_BATCH_MAX_EVENTS	(BUTTON_NAV_RING_SIZE + BUTTON_CONTROL_RING_SIZE)
+#define LED_SCRIPT_BENCHMARK_FRAMES	64	// Scanner frames timed at startup, script and C
+#define DISPLAY_BENCHMARK_FRAMES	64	// Frames latched at startup, one per message and batched
+// Powered off and untouched this long enters STOP mode (EXTI input mode only)
+#define POWER_OFF_STOP_DELAY_MS	3000
+
+// ButtonInputTask thread flags (EXTI input mode)
+#define BTN_FLAG_EDGE		0x01U	// A button pin changed level
+#define BTN_FLAG_DEBOUNCE	0x02U	// A bouncing pin has gone quiet
+#define BTN_FLAG_GESTURE	0x04U	// A press timing window closed, or the menu accepts less
+
+// MenuLogicTask thread flags
+#define MENU_FLAG_BUTTON	0x01U	// A button event was queued on either lane
+#define MENU_FLAG_AUTO_CYCLE	0x02U	// Auto mode period elapsed
+#define MENU_FLAG_KEY		0x04U	// A scanned key edge was queued
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
 static Button_t Buttons[TOTAL_BTNS];
+static Button_bank_t ButtonBank;
+static Gesture_t ButtonGestures;
+static EventRing_t ButtonNavRing;
+static EventRing_t ButtonControlRing;
+static uint32_t button_nav_ring_buffer[BUTTON_NAV_RING_SIZE];
+static uint32_t button_control_ring_buffer[BUTTON_CONTROL_RING_SIZE];
+#if BUTTON_USE_DMA
+static PortSampler_t ButtonSampler;
+#endif
+#if BUTTON_USE_SCAN
+static InputScan_t ButtonScan;
+static ScanKeys_t ScanKeyBank;
+static EventRing_t ScanKeyRing;
+static uint32_t scan_key_ring_buffer[SCAN_KEY_RING_SIZE];
+#if BUTTON_SOURCE == BUTTON_SOURCE_SHIFT_IN
+static SN74HC165_t ButtonShiftIn;
+#else
+static KeyMatrix_t ButtonMatrix;
+#endif
+#endif
 static Menu_t Menu;
+static SettingsStore_t Settings;
+static SettingsStore_flash_t SettingsFlash;
 static SN74HC595_t ShiftRegister;
 static Display_Manager_t DisplayManager;
+static Display_channel_t DisplayChannel;
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
+#define TAP(btn)	GESTURE_TAP(BTN_MASK(btn))
+// Single, double, triple and long press of one button
+#define CLICKS(btn) \
+	{ .id = (btn), .type = SINGLE_PRESS, .length = 1, .strokes = { TAP(btn) } }, \
+	{ .id = (btn), .type = DOUBLE_PRESS, .length = 2, .strokes = { TAP(btn), TAP(btn) }, \
+	  .gap_ms = SINGLE_WINDOW, .window_ms = DOUBLE_WINDOW }, \
+	{ .id = (btn), .type = TRIPLE_PRESS, .length = 3, .strokes = { TAP(btn), TAP(btn), TAP(btn) }, \
+	  .gap_ms = TRIPLE_GAP, .window_ms = TRIPLE_WINDOW }, \
+	{ .id = (btn), .type = LONG_PRESS, .length = 1, .strokes = { GESTURE_HOLD(BTN_MASK(btn)) } }
+
+/* Gesture table, compiled into a trie by Gesture_ctor */
+static const Gesture_def_t button_gesture_table[] = {
+	CLICKS(BTN_1),
+	CLICKS(BTN_2),
+	CLICKS(BTN_3),
+	{ .id = BTN_1, .type = CHORD_PRESS, .length = 1,
+	  .strokes = { GESTURE_TAP(BTN_MASK(BTN_1) | BTN_MASK(BTN_3)) } },
+};
+
+static const Gesture_repeat_cfg_t button_repeat_cfg = {
+	.delay_ms = REPEAT_DELAY_MS,
+	.start_ms = REPEAT_START_MS,
+	.min_ms = REPEAT_MIN_MS,
+	.step_percent = REPEAT_STEP_PERCENT,
+};
 
+// Sent on the control lane: power off/on only. Events whose meaning depends
+// on the page (the BTN2 double press confirms a reset only on RESET_CONFIRM)
+// stay behind the navigation that leads there, or they could overtake it
+// and be dropped on the wrong page.
+static const uint32_t button_control_events = BTN_EVENT_BIT(BTN_3, LONG_PRESS)
+		| BTN_EVENT_BIT(BTN_1, LONG_PRESS);
+/* Definitions for display_msg_pool (static, no heap on the display path) */
+osMemoryPoolId_t display_msg_poolHandle;
+static StaticMemPool_t display_msg_poolControlBlock;
+static uint32_t display_msg_poolBuffer[MEMPOOL_ARR_SIZE(DISPLAY_MSG_POOL_BLOCKS, sizeof(Display_msg_t)) / sizeof(uint32_t)];
+const osMemoryPoolAttr_t display_msg_pool_attributes = {
+  .name = "display_msg_pool",
+  .cb_mem = &display_msg_poolControlBlock,
+  .cb_size = sizeof(display_msg_poolControlBlock),
+  .mp_mem = display_msg_poolBuffer,
+  .mp_size = sizeof(display_msg_poolBuffer)
+};
+#if BUTTON_USE_DMA
+/* Port snapshots written by DMA2 on every TIM1 update */
+static volatile uint16_t button_sample_buffer[BUTTON_DMA_SAMPLES];
+#endif
+#if BUTTON_USE_SCAN && BUTTON_SOURCE == BUTTON_SOURCE_MATRIX
+/* Keypad rows, driven low one at a time */
+static const KeyMatrix_pin_t button_matrix_rows[] = {
+	{ GPIOB, GPIO_PIN_4 },
+	{ GPIOB, GPIO_PIN_5 },
+	{ GPIOB, GPIO_PIN_6 },
+	{ GPIOB, GPIO_PIN_7 },
+};
+#endif
+/* Definitions for menu_auto_timer (periodic, static) */
+osTimerId_t menu_auto_timerHandle;
+static StaticTimer_t menu_auto_timerControlBlock;
+const osTimerAttr_t menu_auto_timer_attributes = {
+  .name = "menu_auto_timer",
+  .cb_mem = &menu_auto_timerControlBlock,
+  .cb_size = sizeof(menu_auto_timerControlBlock)
+};
+#if BUTTON_USE_EXTI
+/* Definitions for button timers (one-shot, static) */
+osTimerId_t button_debounce_timerHandle;
+static StaticTimer_t button_debounce_timerControlBlock;
+const osTimerAttr_t button_debounce_timer_attributes = {
+  .name = "button_debounce_timer",
+  .cb_mem = &button_debounce_timerControlBlock,
+  .cb_size = sizeof(button_debounce_timerControlBlock)
+};
+osTimerId_t button_gesture_timerHandle;
+static StaticTimer_t button_gesture_timerControlBlock;
+const osTimerAttr_t button_gesture_timer_attributes = {
+  .name = "button_gesture_timer",
+  .cb_mem = &button_gesture_timerControlBlock,
+  .cb_size = sizeof(button_gesture_timerControlBlock)
+};
+#endif
 /* USER CODE END Variables */
 /* Definitions for BTN_IN_Thread */
 osThreadId_t BTN_IN_ThreadHandle;
@@ -73,15 +242,16 @@ const osThreadAttr_t DISP_MGR_Thread_attributes = {
   .stack_size = 1024 * 4,
   .priority = (osPriority_t) osPriorityNormal,
 };
-/* Definitions for button_event_queue */
-osMessageQueueId_t button_event_queueHandle;
-const osMessageQueueAttr_t button_event_queue_attributes = {
-  .name = "button_event_queue"
-};
 /* Definitions for display_pattern_queue */
 osMessageQueueId_t display_pattern_queueHandle;
+uint8_t display_pattern_queueBuffer[ 16 * sizeof( Display_msg_t * ) ];
+osStaticMessageQDef_t display_pattern_queueControlBlock;
 const osMessageQueueAttr_t display_pattern_queue_attributes = {
-  .name = "display_pattern_queue"
+  .name = "display_pattern_queue",
+  .cb_mem = &display_pattern_queueControlBlock,
+  .cb_size = sizeof(display_pattern_queueControlBlock),
+  .mq_mem = &display_pattern_queueBuffer,
+  .mq_size = sizeof(display_pattern_queueBuffer)
 };
 /* Definitions for shiftreg_mutex */
 osMutexId_t shiftreg_mutexHandle;
@@ -91,7 +261,10 @@ const osMutexAttr_t shiftreg_mutex_attributes = {
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
-
+static void MenuAutoTimerCallback(void *argument);
+#if BUTTON_USE_EXTI
+static void ButtonTimerCallback(void *argument);
+#endif
 /* USER CODE END FunctionPrototypes */
 
 void ButtonInputTask(void *argument);
@@ -123,17 +296,40 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_TIMERS */
 	/* start timers, add new ones, ... */
+	menu_auto_timerHandle = osTimerNew(MenuAutoTimerCallback, osTimerPeriodic,
+			NULL, &menu_auto_timer_attributes);
+#if BUTTON_USE_EXTI
+	button_debounce_timerHandle = osTimerNew(ButtonTimerCallback, osTimerOnce,
+			(void*) BTN_FLAG_DEBOUNCE, &button_debounce_timer_attributes);
+	button_gesture_timerHandle = osTimerNew(ButtonTimerCallback, osTimerOnce,
+			(void*) BTN_FLAG_GESTURE, &button_gesture_timer_attributes);
+#endif
   /* USER CODE END RTOS_TIMERS */
 
   /* Create the queue(s) */
-  /* creation of button_event_queue */
-  button_event_queueHandle = osMessageQueueNew (16, sizeof(BTN_event_t), &button_event_queue_attributes);
-
   /* creation of display_pattern_queue */
-  display_pattern_queueHandle = osMessageQueueNew (16, sizeof(Display_update_data_t), &display_pattern_queue_attributes);
+  display_pattern_queueHandle = osMessageQueueNew (16, sizeof(Display_msg_t *), &display_pattern_queue_attributes);
 
   /* USER CODE BEGIN RTOS_QUEUES */
 	/* add queues, ... */
+	display_msg_poolHandle = osMemoryPoolNew(DISPLAY_MSG_POOL_BLOCKS,
+			sizeof(Display_msg_t), &display_msg_pool_attributes);
+	Display_channel_ctor(&DisplayChannel, display_pattern_queueHandle,
+			display_msg_poolHandle);
+	EventRing_ctor(&ButtonNavRing, button_nav_ring_buffer, BUTTON_NAV_RING_SIZE);
+	EventRing_ctor(&ButtonControlRing, button_control_ring_buffer,
+			BUTTON_CONTROL_RING_SIZE);
+	if (!Gesture_ctor(&ButtonGestures, button_gesture_table,
+			sizeof(button_gesture_table) / sizeof(button_gesture_table[0]),
+			&button_repeat_cfg, &ButtonControlRing, &ButtonNavRing)) {
+		Error_Handler(); // Table needs more than GESTURE_MAX_STATES
+	}
+	Gesture_set_control_events(&ButtonGestures, button_control_events);
+#if BUTTON_USE_SCAN
+	// The chain's inputs past the gesture buttons are raw keys
+	EventRing_ctor(&ScanKeyRing, scan_key_ring_buffer, SCAN_KEY_RING_SIZE);
+	ScanKeys_ctor(&ScanKeyBank, TOTAL_BTNS, SCAN_INPUTS, &ScanKeyRing);
+#endif
   /* USER CODE END RTOS_QUEUES */
 
   /* Create the thread(s) */
@@ -166,17 +362,125 @@ void MX_FREERTOS_Init(void) {
 void ButtonInputTask(void *argument)
 {
   /* USER CODE BEGIN ButtonInputTask */
-	Button_ctor(&Buttons[0], BTN_1, BTN_1_GPIO_Port, BTN_1_Pin,
-			button_event_queueHandle);
-	Button_ctor(&Buttons[1], BTN_2, BTN_2_GPIO_Port, BTN_2_Pin,
-				button_event_queueHandle);
-	Button_ctor(&Buttons[2], BTN_3, BTN_3_GPIO_Port, BTN_3_Pin,
-				button_event_queueHandle);
+#if !BUTTON_USE_SCAN
+	Button_ctor(&Buttons[0], BTN_1, BTN_1_GPIO_Port, BTN_1_Pin);
+	Button_ctor(&Buttons[1], BTN_2, BTN_2_GPIO_Port, BTN_2_Pin);
+	Button_ctor(&Buttons[2], BTN_3, BTN_3_GPIO_Port, BTN_3_Pin);
+	// All three buttons sit on GPIOB, so one IDR read covers them
+	Button_bank_ctor(&ButtonBank, BTN_1_GPIO_Port, Buttons, TOTAL_BTNS,
+			&ButtonGestures);
+#else
+	// The gesture buttons are the first inputs of the scanned chain
+	for (uint8_t i = 0; i < TOTAL_BTNS; i++) {
+		Button_ctor(&Buttons[i], (BTN_id_e) i, NULL, 1U << i);
+	}
+	Button_bank_ctor(&ButtonBank, NULL, Buttons, TOTAL_BTNS, &ButtonGestures);
+#endif
+#if BUTTON_USE_EXTI
+	// The menu narrowing what it accepts can end a press window early
+	Gesture_set_owner(&ButtonGestures, osThreadGetId(), BTN_FLAG_GESTURE);
+
+	/* Infinite loop */
+	for (;;) {
+		// Sleep until a pin moves or one of the one-shot timers expires
+		uint32_t flags = osThreadFlagsWait(
+				BTN_FLAG_EDGE | BTN_FLAG_DEBOUNCE | BTN_FLAG_GESTURE,
+				osFlagsWaitAny, osWaitForever);
+
+		if (flags & (BTN_FLAG_DEBOUNCE | BTN_FLAG_GESTURE)) {
+			Button_bank_settled(&ButtonBank);
+		}
+
+		if (flags & (BTN_FLAG_EDGE | BTN_FLAG_DEBOUNCE)) {
+			// Every bounce pushes out that button's own debounce window
+			uint32_t quiet = Button_bank_settle_deadline_ms(&ButtonBank,
+					Clock_now_us());
+			if (quiet != osWaitForever) {
+				osTimerStart(button_debounce_timerHandle, (quiet > 0) ? quiet : 1);
+			}
+		}
+
+		if (flags & (BTN_FLAG_DEBOUNCE | BTN_FLAG_GESTURE)) {
+			uint32_t next = Button_bank_next_deadline_ms(&ButtonBank,
+					Clock_now_us());
+
+			// Wake again only when a press window closes
+			if (next == osWaitForever) {
+				osTimerStop(button_gesture_timerHandle);
+			} else {
+				osTimerStart(button_gesture_timerHandle, (next > 0) ? next : 1);
+			}
+		}
+	}
+#elif BUTTON_USE_DMA
+	// Edges are not needed while the port is sampled
+	HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+	PortSampler_ctor(&ButtonSampler, &htim1, BTN_1_GPIO_Port,
+			button_sample_buffer, BUTTON_DMA_SAMPLES);
+	if (!PortSampler_start(&ButtonSampler)) {
+		Error_Handler();
+	}
+
+	uint16_t batch[BUTTON_DMA_SAMPLES];
+	/* Infinite loop */
+	for (;;) {
+		// Sample timing comes from TIM1, so wake-up jitter only delays the
+		// batch, it never moves an edge
+		uint16_t count = PortSampler_read(&ButtonSampler, batch,
+				BUTTON_DMA_SAMPLES);
+		uint32_t now = Clock_now_us();
+		Button_bank_process(&ButtonBank, batch, count, now);
+
+		// Wake sooner when a repeat or press window is due before the next batch
+		uint32_t wait = Button_bank_next_deadline_ms(&ButtonBank, now);
+		osDelay((wait < BUTTON_BATCH_MS) ? ((wait > 0) ? wait : 1) : BUTTON_BATCH_MS);
+	}
+#else
+	// The on-board buttons are not used while a chain is scanned
+	HAL_NVIC_DisableIRQ(EXTI15_10_IRQn);
+#if BUTTON_SOURCE == BUTTON_SOURCE_SHIFT_IN
+	// Scan and debounce cost of 8, 16, 32 and 64 input chains, the same
+	// pins clocked for 1, 2, 4 and 8 chips
+	static ScanKeys_t bench_keys;
+	for (uint8_t chips = 1; chips <= SN74HC165_MAX_CHIPS; chips *= 2) {
+		SN74HC165_ctor(&ButtonShiftIn, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1,
+				GPIOA, GPIO_PIN_4, chips);
+		InputScan_ctor(&ButtonScan, "74HC165", SN74HC165_read, &ButtonShiftIn,
+				chips * 8);
+		InputScan_benchmark(&ButtonScan, SCAN_BENCHMARK_RUNS);
+		ScanKeys_ctor(&bench_keys, TOTAL_BTNS, chips * 8, NULL);
+		ScanKeys_benchmark(&bench_keys, SCAN_BENCHMARK_RUNS);
+	}
+
+	SN74HC165_ctor(&ButtonShiftIn, GPIOA, GPIO_PIN_0, GPIOA, GPIO_PIN_1,
+			GPIOA, GPIO_PIN_4, SCAN_SHIFT_IN_CHIPS);
+	InputScan_ctor(&ButtonScan, "74HC165", SN74HC165_read, &ButtonShiftIn,
+			SCAN_INPUTS);
+#else
+	KeyMatrix_ctor(&ButtonMatrix, button_matrix_rows,
+			sizeof(button_matrix_rows) / sizeof(button_matrix_rows[0]), GPIOA,
+			SCAN_MATRIX_COL_FIRST, SCAN_MATRIX_COLS, SCAN_MATRIX_SETTLE_CYCLES);
+	InputScan_ctor(&ButtonScan, "Key matrix", KeyMatrix_scan, &ButtonMatrix,
+			SCAN_INPUTS);
+	InputScan_benchmark(&ButtonScan, SCAN_BENCHMARK_RUNS);
+	ScanKeys_benchmark(&ScanKeyBank, SCAN_BENCHMARK_RUNS);
+#endif
+
+	uint32_t words[INPUT_SCAN_WORDS];
+	uint32_t wake = osKernelGetTickCount();
 	/* Infinite loop */
 	for (;;) {
-		for(int i = 0;i<TOTAL_BTNS;i++) { Button_read(&Buttons[i]); }
-		osDelay(5);
+		// Every input is read each period: the gesture buttons go to the
+		// bank, every other input to the raw key bank
+		InputScan_read(&ButtonScan, words);
+		uint32_t now = Clock_now_us();
+		Button_bank_process_scan(&ButtonBank, words[0], now);
+		ScanKeys_process(&ScanKeyBank, words, now);
+
+		wake += BUTTON_SAMPLE_MS * osKernelGetTickFreq() / 1000U;
+		osDelayUntil(wake);
 	}
+#endif
   /* USER CODE END ButtonInputTask */
 }
 
@@ -190,37 +494,165 @@ void ButtonInputTask(void *argument)
 void MenuLogicTask(void *argument)
 {
   /* USER CODE BEGIN MenuLogicTask */
-	osStatus_t status;
-	BTN_event_t event;
-	uint32_t last_auto_cycle_time = 0;
+	BTN_event_t events[MENU_BATCH_MAX_EVENTS];
+	uint8_t count;
+	uint32_t flags;
+	uint16_t auto_period = 0; // Running timer period, 0 = stopped
+	uint32_t now;
+	uint32_t timeout;
+#if BUTTON_USE_EXTI
+	uint32_t last_input = osKernelGetTickCount();
+#endif
+	bool was_powered_off;
+	uint32_t snapshot[MENU_SNAPSHOT_WORDS];
+	LowPower_stats_t power_stats;
+
+	// Reset while powered off: the backup registers still hold the menu, so
+	// the first frame goes out before anything else and nothing is logged
+	bool is_resumed = LowPower_load(snapshot, MENU_SNAPSHOT_WORDS)
+			&& Menu_resume_ctor(&Menu, &DisplayChannel, &Settings, snapshot);
+	uint32_t first_frame_us = Clock_now_us();
 
 	// Initialize Menu
-	Menu_ctor(&Menu, display_pattern_queueHandle);
-	log_message("MenuLogic", LOG_INFO, "Menu Logic Task started");
+	// Only the latest record is read, so the mount cost stays flat as the log grows
+	uint32_t mount_start = DWT->CYCCNT;
+	SettingsFlash_ctor(&SettingsFlash);
+	SettingsStore_ctor(&Settings, &SettingsFlash);
+	uint32_t mount_cycles = DWT->CYCCNT - mount_start;
+
+	if (is_resumed) {
+		log_message("MenuLogic", LOG_INFO, "Resumed page %d from backup registers, first frame %luus after reset",
+		            Menu.current_page, first_frame_us);
+	} else {
+		log_message("MenuLogic", LOG_INFO, "Settings: mounted in %lu us, %u records read, %u erases so far",
+		            mount_cycles / (SystemCoreClock / 1000000U), Settings.stats.probes,
+		            Settings.stats.erases);
+		Menu_ctor(&Menu, &DisplayChannel, &Settings);
+	}
+	Gesture_set_accepted(&ButtonGestures, Menu_accepted_events(&Menu));
+	Gesture_set_consumer(&ButtonGestures, osThreadGetId(), MENU_FLAG_BUTTON);
+#if BUTTON_USE_SCAN
+	ScanKeys_set_consumer(&ScanKeyBank, osThreadGetId(), MENU_FLAG_KEY);
+	ScanKeys_event_t key;
+#endif
+	if (!is_resumed) {
+		log_message("MenuLogic", LOG_INFO, "Menu Logic Task started");
+		Gesture_benchmark_delivery(BUTTON_DELIVERY_BENCHMARK_RUNS);
+		LedScript_benchmark(LED_SCRIPT_BENCHMARK_FRAMES);
+	}
 
 	/* Infinite loop */
 	for (;;) {
-		// Check for button events (with timeout to allow auto-cycle checking)
-		status = osMessageQueueGet(button_event_queueHandle, (void*) &event, 0, 100);
-
-		if (status == osOK) {
-			// Process button event
-			log_message("MenuLogic", LOG_INFO, "BTN:%d EVT:%d TS:%lu",
-			            event.id, event.type, event.timestamp);
-			Menu_process_input(&Menu, event);
+		// Changed settings go to flash once the menu has been idle a while
+		now = osKernelGetTickCount();
+		SettingsStore_service(&Settings, now);
+		timeout = SettingsStore_next_deadline_ms(&Settings, now);
+
+		// Auto mode scripts step on their own deadlines
+		Menu_script_service(&Menu, now);
+		uint32_t script_timeout = Menu_script_next_deadline_ms(&Menu, now);
+		if (script_timeout < timeout) {
+			timeout = script_timeout;
+		}
+
+#if BUTTON_USE_EXTI
+		// Powered off and quiet: keep the menu in the backup registers and
+		// stop the clocks until a button edge
+		if (Menu_is_powered_off(&Menu)) {
+			uint32_t idle = now - last_input;
+			if (idle >= POWER_OFF_STOP_DELAY_MS && Button_bank_is_idle(&ButtonBank)) {
+				SettingsStore_flush(&Settings);
+				Menu_get_snapshot(&Menu, snapshot);
+				LowPower_save(snapshot, MENU_SNAPSHOT_WORDS);
+				LowPower_stop();
+				last_input = osKernelGetTickCount();
+				continue;
+			}
+			// A button still down is looked at again after another delay
+			uint32_t left = (idle < POWER_OFF_STOP_DELAY_MS) ?
+					POWER_OFF_STOP_DELAY_MS - idle : POWER_OFF_STOP_DELAY_MS;
+			if (left < timeout) {
+				timeout = left;
+			}
+		}
+#endif
+
+		// Sleep until a button event, an auto mode step, a script step, the
+		// settings write or the power-off stop
+		flags = osThreadFlagsWait(MENU_FLAG_BUTTON | MENU_FLAG_AUTO_CYCLE | MENU_FLAG_KEY,
+				osFlagsWaitAny, timeout);
+		if (flags & osFlagsError) {
+			continue;
+		}
+#if BUTTON_USE_SCAN
+		// No page uses the extra keys yet, they are only reported
+		while (ScanKeys_receive(&ScanKeyBank, &key)) {
+			log_message("MenuLogic", LOG_INFO, "KEY:%u %s TS:%luus", key.key,
+			            key.is_pressed ? "down" : "up", key.timestamp);
+		}
+#endif
+		was_powered_off = Menu_is_powered_off(&Menu);
+
+		// Drain everything pending, control lane first; several events are
+		// fast-forwarded and only the final frame is drawn
+		do {
+			count = 0;
+			while (count < MENU_BATCH_MAX_EVENTS
+					&& Gesture_receive(&ButtonGestures, &events[count])) {
+				count++;
+			}
+
+			if (count == 1) {
+				// Process button event
+				log_message("MenuLogic", LOG_INFO, "BTN:%d EVT:%d TS:%luus",
+				            events[0].id, events[0].type, events[0].timestamp);
+				Menu_process_input(&Menu, events[0]);
+			} else if (count > 1) {
+				Menu_begin_batch(&Menu);
+				for (uint8_t i = 0; i < count; i++) {
+					Menu_process_input(&Menu, events[i]);
+				}
+				Menu_end_batch(&Menu);
+			}
+			// Single presses on pages without multi-press go out on release
+			Gesture_set_accepted(&ButtonGestures, Menu_accepted_events(&Menu));
+#if BUTTON_USE_EXTI
+			if (count > 0) {
+				last_input = osKernelGetTickCount();
+			}
+#endif
+		} while (count == MENU_BATCH_MAX_EVENTS);
+
+		if (was_powered_off && !Menu_is_powered_off(&Menu)) {
+			// The power-on frame is queued; a later reset starts cold
+			first_frame_us = Clock_now_us();
+			LowPower_clear();
+			LowPower_get_stats(&power_stats);
+			if (power_stats.stops > 0) {
+				log_message("MenuLogic", LOG_INFO, "Woke from STOP: clocks back in %luus (max %luus), first frame %luus after wake",
+				            power_stats.last_resume_us, power_stats.max_resume_us,
+				            first_frame_us - power_stats.wake_time);
+			}
 		}
 
-		// Handle auto-mode pattern cycling (every 2 seconds)
-		if (Menu_is_auto_mode_active()) {
-			uint32_t current_time = HAL_GetTick();
-			if ((current_time - last_auto_cycle_time) >= AUTO_CYCLE_PERIOD_MS) {
-				Menu_auto_cycle_pattern(&Menu);
-				last_auto_cycle_time = current_time;
-				log_message("MenuLogic", LOG_DEBUG, "Auto mode: Pattern cycled");
+		// A tick left over from before auto mode was exited is ignored
+		if ((flags & MENU_FLAG_AUTO_CYCLE) && Menu_is_auto_mode_active(&Menu)) {
+			Menu_auto_cycle_pattern(&Menu);
+			log_message("MenuLogic", LOG_DEBUG, "Auto mode: Pattern cycled");
+		}
+
+		// The periodic timer reloads from its previous expiry, so the period
+		// does not drift; it runs only in auto mode and restarts on a speed change
+		// A script paces itself, the timer only cycles patterns
+		uint16_t period = (Menu_is_auto_mode_active(&Menu) && !Menu_is_script_playing(&Menu)) ?
+				Menu_auto_cycle_period_ms(&Menu) : 0;
+		if (period != auto_period) {
+			if (period == 0) {
+				osTimerStop(menu_auto_timerHandle);
+			} else {
+				osTimerStart(menu_auto_timerHandle, period);
 			}
-		} else {
-			// Reset the timer when not in auto mode
-			last_auto_cycle_time = HAL_GetTick();
+			auto_period = period;
 		}
 	}
   /* USER CODE END MenuLogicTask */
@@ -237,7 +669,7 @@ void DisplayManagerTask(void *argument)
 {
   /* USER CODE BEGIN DisplayManagerTask */
 	osStatus_t status;
-		Display_update_data_t display_data;
+		Display_msg_t *display_msg;
 
 		// Initialize Shift Register
 		// Pin mappings from main.h:
@@ -256,32 +688,70 @@ void DisplayManagerTask(void *argument)
 		// Initialize Display Manager
 		Display_ctor(&DisplayManager,
 		             &ShiftRegister,
-		             display_pattern_queueHandle,
+		             &DisplayChannel,
 		             shiftreg_mutexHandle);
 
+		Display_set_frame_rate(&DisplayManager, DISPLAY_FRAME_RATE_HZ);
+		Display_set_idle_timeout(&DisplayManager, DISPLAY_IDLE_DIM_MS,
+				DISPLAY_DIM_STEP_MS);
+
 		log_message("DisplayMgr", LOG_INFO, "Display Manager Task started");
 
+		// Skipped on a resume from power off, the first frame is waiting
+		uint32_t snapshot[MENU_SNAPSHOT_WORDS];
+		if (!LowPower_load(snapshot, MENU_SNAPSHOT_WORDS)) {
+			Display_benchmark_submission(&DisplayManager, DISPLAY_BENCHMARK_FRAMES);
+		}
+
 		/* Infinite loop */
 		for (;;) {
+			if (Display_get_frame_rate(&DisplayManager) != 0) {
+				// Fixed-rate mode: latch only dirty frames on a steady clock
+				Display_render_frame(&DisplayManager);
+				Display_wait_next_frame(&DisplayManager);
+				continue;
+			}
+
 			// Wait for display update requests from Menu
+			// (or until the next inactivity dimming step is due)
 			status = osMessageQueueGet(display_pattern_queueHandle,
-			                           (void*) &display_data,
+			                           (void*) &display_msg,
 			                           0,
-			                           osWaitForever);
+			                           Display_idle_wait_ticks(&DisplayManager));
 
 			if (status == osOK) {
-				// Process the display update
-				if (Display_update(&DisplayManager, &display_data)) {
+				// Process the display update (single frame or batch)
+				if (Display_handle_message(&DisplayManager, display_msg)) {
 				} else {
 					log_message("DisplayMgr", LOG_ERROR, "Display update failed");
 				}
 			}
+
+			Display_service_idle(&DisplayManager);
 		}
   /* USER CODE END DisplayManagerTask */
 }
 
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
+static void MenuAutoTimerCallback(void *argument)
+{
+	osThreadFlagsSet(MENU_ThreadHandle, MENU_FLAG_AUTO_CYCLE);
+}
+
+#if BUTTON_USE_EXTI
+static void ButtonTimerCallback(void *argument)
+{
+	osThreadFlagsSet(BTN_IN_ThreadHandle, (uint32_t) argument);
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	uint32_t now = Clock_now_us();
 
+	Button_bank_edge_from_isr(&ButtonBank, GPIO_Pin, now);
+	osThreadFlagsSet(BTN_IN_ThreadHandle, BTN_FLAG_EDGE);
+}
+#endif
 /* USER CODE END Application */
 
@@ -20,6 +20,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_tim.h"
+#include "Clock.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -31,8 +32,9 @@ TIM_HandleTypeDef        htim5;
 
 /**
   * @brief  This function configures the TIM5 as a time base source.
-  *         The time source is configured  to have 1ms time base with a dedicated
-  *         Tick interrupt priority.
+  *         TIM5 free-runs at 1MHz over its full 32 bits (the microsecond
+  *         clock, see Clock.h) and compare channel 1 raises the 1ms tick,
+  *         with a dedicated Tick interrupt priority.
   * @note   This function is called  automatically at the beginning of program after
   *         reset by HAL_Init() or at any time when clock is configured, by HAL_RCC_ClockConfig().
   * @param  TickPriority: Tick interrupt priority.
@@ -73,12 +75,13 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
   htim5.Instance = TIM5;
 
   /* Initialize TIMx peripheral as follow:
-   * Period = [(TIM5CLK/1000) - 1]. to have a (1/1000) s time base.
+   * Period = 0xFFFFFFFF, free-running; the update interrupt extends it to 64 bits.
    * Prescaler = (uwTimclock/1000000 - 1) to have a 1MHz counter clock.
    * ClockDivision = 0
    * Counter direction = Up
+   * Channel 1 compare every 1000 counts gives the (1/1000) s time base.
    */
-  htim5.Init.Period = (1000000U / 1000U) - 1U;
+  htim5.Init.Period = 0xFFFFFFFFU;
   htim5.Init.Prescaler = uwPrescalerValue;
   htim5.Init.ClockDivision = 0;
   htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
@@ -87,6 +90,13 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
   status = HAL_TIM_Base_Init(&htim5);
   if (status == HAL_OK)
   {
+    /* First tick one period from now, on a frozen output compare */
+    __HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_1, __HAL_TIM_GET_COUNTER(&htim5) + CLOCK_TICK_US);
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+    /* The init update event is not an overflow of the clock */
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC1);
+
     /* Start the TIM time Base generation in interrupt mode */
     status = HAL_TIM_Base_Start_IT(&htim5);
     if (status == HAL_OK)
@@ -113,25 +123,27 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 
 /**
   * @brief  Suspend Tick increment.
-  * @note   Disable the tick increment by disabling TIM5 update interrupt.
+  * @note   Disable the tick increment by disabling TIM5 channel 1 interrupt.
+  *         The microsecond clock keeps running.
   * @param  None
   * @retval None
   */
 void HAL_SuspendTick(void)
 {
-  /* Disable TIM5 update Interrupt */
-  __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_UPDATE);
+  /* Disable TIM5 compare Interrupt */
+  __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_CC1);
 }
 
 /**
   * @brief  Resume Tick increment.
-  * @note   Enable the tick increment by Enabling TIM5 update interrupt.
+  * @note   Enable the tick increment by Enabling TIM5 channel 1 interrupt.
   * @param  None
   * @retval None
   */
 void HAL_ResumeTick(void)
 {
-  /* Enable TIM5 Update interrupt */
-  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_UPDATE);
+  /* Next tick one period from now, then enable TIM5 compare Interrupt */
+  Clock_resume_tick();
+  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC1);
 }
 
@@ -0,0 +1,187 @@
+/*
+ * menu_fleet.c
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+// Runs thousands of Menu_t instances on a Linux host, spread over one
+// thread per core, feeds them synthetic button traffic and reports the
+// dispatch rate. Every menu is owned by one thread, so nothing is locked.
+//
+//   menu_fleet [threads] [menus per thread] [events per menu]
+
+#include "port_host.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FLEET_DEFAULT_MENUS  1000
+#define FLEET_DEFAULT_EVENTS 1000
+#define FLEET_EVENT_MS       20     // Simulated time between events of one menu
+#define FLEET_AUTO_CYCLE_EVENTS 50  // Auto mode tick every this many events
+
+typedef struct {
+	uint32_t seed;
+	uint32_t menus;
+	uint32_t events;
+	Menu_t *fleet;
+	Display_channel_t *channels;
+	uint64_t dispatched;
+	uint64_t frames;
+	uint32_t errors;
+	double seconds;
+} Worker_t;
+
+static uint32_t next_random(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+// Mostly single presses so the menus travel, some of everything else
+static BTN_event_t random_event(uint32_t *random, uint32_t now_ms) {
+	static const uint8_t TYPE_WEIGHTS[TOTAL_BTN_EVENTS] = {
+		[SINGLE_PRESS] = 70, [DOUBLE_PRESS] = 10, [TRIPLE_PRESS] = 3, [LONG_PRESS] = 4,
+		[CHORD_PRESS] = 1, [SEQUENCE_PRESS] = 2, [REPEAT] = 10,
+	};
+	uint32_t r = next_random(random);
+	uint32_t pick = (r >> 8) % 100U;
+	BTN_event_t event = { .id = (BTN_id_e) (r % TOTAL_BTNS), .type = SINGLE_PRESS,
+			.timestamp = now_ms * 1000U, .is_speculative = false };
+
+	for (uint8_t type = 0; type < TOTAL_BTN_EVENTS; type++) {
+		if (pick < TYPE_WEIGHTS[type]) {
+			event.type = (BTN_event_e) type;
+			break;
+		}
+		pick -= TYPE_WEIGHTS[type];
+	}
+	return event;
+}
+
+static bool is_sane(const Menu_t *menu) {
+	return menu->current_page < TOTAL_PAGES && menu->settings.brightness <= 10
+			&& menu->settings.auto_period_ms >= 250 && menu->settings.auto_period_ms <= 8000
+			&& !menu->speculation.is_active;
+}
+
+static void *run_worker(void *argument) {
+	Worker_t *worker = argument;
+	uint32_t random = worker->seed;
+	uint32_t now_ms = 0;
+
+	for (uint32_t m = 0; m < worker->menus; m++) {
+		Host_display_channel_ctor(&worker->channels[m]);
+		Menu_ctor(&worker->fleet[m], &worker->channels[m], NULL);
+	}
+
+	double start = now_s();
+	for (uint32_t e = 0; e < worker->events; e++) {
+		now_ms += FLEET_EVENT_MS;
+		for (uint32_t m = 0; m < worker->menus; m++) {
+			Menu_t *menu = &worker->fleet[m];
+			BTN_event_t event = random_event(&random, now_ms);
+
+			if ((next_random(&random) % 10U) == 0) {
+				// A single press reported ahead of a possible double press,
+				// then confirmed or replaced
+				event.type = SINGLE_PRESS;
+				event.is_speculative = true;
+				Menu_process_input(menu, event);
+				event.is_speculative = false;
+				if (next_random(&random) & 1U) {
+					event.type = DOUBLE_PRESS;
+				}
+				worker->dispatched++;
+			}
+			Menu_process_input(menu, event);
+			worker->dispatched++;
+
+			Menu_script_service(menu, now_ms);
+			if ((e % FLEET_AUTO_CYCLE_EVENTS) == 0 && Menu_is_auto_mode_active(menu)) {
+				Menu_auto_cycle_pattern(menu);
+			}
+		}
+	}
+	worker->seconds = now_s() - start;
+
+	for (uint32_t m = 0; m < worker->menus; m++) {
+		worker->frames += worker->channels[m].frames;
+		if (!is_sane(&worker->fleet[m])) {
+			worker->errors++;
+		}
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv) {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t threads = (argc > 1) ? (uint32_t) atoi(argv[1]) : (uint32_t) ((cores > 0) ? cores : 1);
+	uint32_t menus = (argc > 2) ? (uint32_t) atoi(argv[2]) : FLEET_DEFAULT_MENUS;
+	uint32_t events = (argc > 3) ? (uint32_t) atoi(argv[3]) : FLEET_DEFAULT_EVENTS;
+
+	if (threads == 0 || menus == 0 || events == 0) {
+		fprintf(stderr, "usage: %s [threads] [menus per thread] [events per menu]\n", argv[0]);
+		return 2;
+	}
+
+	Worker_t *workers = calloc(threads, sizeof(Worker_t));
+	pthread_t *ids = calloc(threads, sizeof(pthread_t));
+	if (workers == NULL || ids == NULL) {
+		return 1;
+	}
+	for (uint32_t t = 0; t < threads; t++) {
+		workers[t].seed = 0x9E3779B9U * (t + 1U);
+		workers[t].menus = menus;
+		workers[t].events = events;
+		workers[t].fleet = calloc(menus, sizeof(Menu_t));
+		workers[t].channels = calloc(menus, sizeof(Display_channel_t));
+		if (workers[t].fleet == NULL || workers[t].channels == NULL) {
+			return 1;
+		}
+	}
+
+	double start = now_s();
+	for (uint32_t t = 0; t < threads; t++) {
+		pthread_create(&ids[t], NULL, run_worker, &workers[t]);
+	}
+	uint64_t dispatched = 0;
+	uint64_t frames = 0;
+	uint32_t errors = 0;
+	for (uint32_t t = 0; t < threads; t++) {
+		pthread_join(ids[t], NULL);
+		dispatched += workers[t].dispatched;
+		frames += workers[t].frames;
+		errors += workers[t].errors;
+		printf("thread %u: %llu events in %.3f s, %.0f events/s\n", t,
+				(unsigned long long) workers[t].dispatched, workers[t].seconds,
+				(double) workers[t].dispatched / workers[t].seconds);
+	}
+	double seconds = now_s() - start;
+
+	printf("menu_fleet: %u threads x %u menus (%u bytes each), %u events per menu\n",
+			threads, menus, (unsigned) sizeof(Menu_t), events);
+	printf("menu_fleet: %llu events in %.3f s, %.0f events/s, %llu frames, %llu log lines, %u menus in a bad state\n",
+			(unsigned long long) dispatched, seconds, (double) dispatched / seconds,
+			(unsigned long long) frames, (unsigned long long) Host_log_lines(), errors);
+
+	for (uint32_t t = 0; t < threads; t++) {
+		free(workers[t].fleet);
+		free(workers[t].channels);
+	}
+	free(workers);
+	free(ids);
+	return (errors == 0) ? 0 : 1;
+}
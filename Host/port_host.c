@@ -0,0 +1,76 @@
+/*
+ * port_host.c
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#include "port_host.h"
+#include "debug_logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static bool is_log_verbose;
+static uint64_t log_lines;
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+uint32_t Port_cycles(void) {
+	return (uint32_t) now_ns();
+}
+
+uint32_t Port_now_us(void) {
+	return (uint32_t) (now_ns() / 1000U);
+}
+
+void Port_notify(Port_thread_t thread, uint32_t flag) {
+	__atomic_fetch_or((uint32_t*) thread, flag, __ATOMIC_RELEASE);
+}
+
+void Host_display_channel_ctor(Display_channel_t *const channel) {
+	memset(channel, 0, sizeof(*channel));
+}
+
+Display_msg_t *Display_channel_alloc(Display_channel_t *const channel) {
+	return &channel->msg;
+}
+
+bool Display_channel_send(Display_channel_t *const channel, Display_msg_t *msg) {
+	if (msg->type == DISPLAY_MSG_UPDATE) {
+		channel->frames++;
+		channel->pattern = msg->update.data;
+		channel->brightness = msg->update.brightness;
+	} else if (msg->type == DISPLAY_MSG_ACTIVITY) {
+		channel->activity++;
+	}
+	return true;
+}
+
+void Host_log_set_verbose(bool is_verbose) {
+	is_log_verbose = is_verbose;
+}
+
+uint64_t Host_log_lines(void) {
+	return __atomic_load_n(&log_lines, __ATOMIC_RELAXED);
+}
+
+// Called from every fleet thread: one fprintf per line keeps lines whole
+void log_message(const char *tag, log_level_t level, const char *format, ...) {
+	char line[256];
+	va_list args;
+
+	__atomic_fetch_add(&log_lines, 1, __ATOMIC_RELAXED);
+	if (!is_log_verbose && level < LOG_WARN) {
+		return;
+	}
+	va_start(args, format);
+	vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	fprintf(stderr, "[%s] %s\n", tag, line);
+}
@@ -0,0 +1,31 @@
+/*
+ *  @file port_host.h
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+#ifndef PORT_HOST_H_
+#define PORT_HOST_H_
+
+#include "Port.h"
+#include "Menu.h"
+
+// Host display channel: every message is consumed as soon as it is sent,
+// so one block is enough. Only the menu writes it, one channel per menu.
+struct Display_channel_s {
+	Display_msg_t msg;
+	uint32_t frames;            // DISPLAY_MSG_UPDATE messages sent
+	uint32_t activity;          // DISPLAY_MSG_ACTIVITY messages sent
+	uint16_t pattern;           // Last frame
+	uint8_t brightness;
+};
+
+void Host_display_channel_ctor(Display_channel_t *const channel);
+
+// log_message lines at LOG_WARN and above go to stderr, the rest are only
+// counted; set verbose to print everything
+void Host_log_set_verbose(bool is_verbose);
+uint64_t Host_log_lines(void);
+
+#endif /* PORT_HOST_H_ */
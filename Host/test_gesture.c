@@ -0,0 +1,184 @@
+/*
+ * test_gesture.c
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+// Recognizer checks for presses that overlap: rolling presses, chords and
+// holds while another button is down. Times are in ms, fed as us.
+
+#include "Gesture.h"
+#include <stdio.h>
+
+#define MS(t) ((uint32_t) (t) * 1000U)
+#define TAP(btn) GESTURE_TAP(BTN_MASK(btn))
+#define CLICKS(btn) \
+	{ .id = (btn), .type = SINGLE_PRESS, .length = 1, .strokes = { TAP(btn) } }, \
+	{ .id = (btn), .type = DOUBLE_PRESS, .length = 2, .strokes = { TAP(btn), TAP(btn) }, \
+	  .gap_ms = 300, .window_ms = 500 }, \
+	{ .id = (btn), .type = LONG_PRESS, .length = 1, .strokes = { GESTURE_HOLD(BTN_MASK(btn)) } }
+
+static const Gesture_def_t table[] = {
+	CLICKS(BTN_1),
+	CLICKS(BTN_2),
+	CLICKS(BTN_3),
+	{ .id = BTN_1, .type = CHORD_PRESS, .length = 1,
+	  .strokes = { GESTURE_TAP(BTN_MASK(BTN_1) | BTN_MASK(BTN_3)) } },
+};
+
+#define SINGLES_AND_LONGS \
+	(BTN_EVENT_BIT(BTN_1, SINGLE_PRESS) | BTN_EVENT_BIT(BTN_2, SINGLE_PRESS) \
+	| BTN_EVENT_BIT(BTN_3, SINGLE_PRESS) | BTN_EVENT_BIT(BTN_1, LONG_PRESS) \
+	| BTN_EVENT_BIT(BTN_3, LONG_PRESS))
+
+static Gesture_t gesture;
+static EventRing_t ring;
+static uint32_t ring_buffer[16];
+static uint32_t clock_ms;
+static int failures;
+
+static void setup(uint32_t accepted) {
+	EventRing_ctor(&ring, ring_buffer, 16);
+	Gesture_ctor(&gesture, table, sizeof(table) / sizeof(table[0]), NULL, NULL, &ring);
+	Gesture_set_accepted(&gesture, accepted);
+	clock_ms = 1000;
+}
+
+// Tick every ms up to t, the way the input task wakes on deadlines
+static void run_to(uint32_t t) {
+	while (clock_ms < t) {
+		clock_ms++;
+		Gesture_tick(&gesture, MS(clock_ms));
+	}
+}
+
+static void edge(uint32_t t, BTN_id_e id, bool is_pressed) {
+	run_to(t);
+	Gesture_edge(&gesture, id, is_pressed, MS(t));
+}
+
+// Compares the settled events with the expected ones, in order
+static void expect(const char *name, const BTN_event_t *want, uint8_t count) {
+	BTN_event_t got;
+	uint8_t n = 0;
+	bool is_ok = true;
+
+	while (Gesture_receive(&gesture, &got)) {
+		if (got.is_speculative) {
+			continue;
+		}
+		if (n >= count || got.id != want[n].id || got.type != want[n].type) {
+			is_ok = false;
+		}
+		n++;
+	}
+	if (!is_ok || n != count) {
+		printf("FAIL %s: %u events, expected %u\n", name, n, count);
+		failures++;
+	} else {
+		printf("ok   %s\n", name);
+	}
+}
+
+#define EVENT(btn, kind) { .id = (btn), .type = (kind) }
+
+int main(void) {
+	// BTN2 pressed before BTN1 is released: two singles, in press order
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_1, true);
+	edge(1080, BTN_2, true);
+	edge(1120, BTN_1, false);
+	edge(1200, BTN_2, false);
+	run_to(2000);
+	expect("rolling press", (BTN_event_t[]) { EVENT(BTN_1, SINGLE_PRESS), EVENT(BTN_2, SINGLE_PRESS) }, 2);
+
+	// Released in the other order, still reported in press order
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_3, true);
+	edge(1050, BTN_2, true);
+	edge(1100, BTN_2, false);
+	edge(1150, BTN_3, false);
+	run_to(2000);
+	expect("nested press", (BTN_event_t[]) { EVENT(BTN_3, SINGLE_PRESS), EVENT(BTN_2, SINGLE_PRESS) }, 2);
+
+	// The chord is reported when accepted, else the buttons fall back to singles
+	setup(SINGLES_AND_LONGS | BTN_EVENT_BIT(BTN_1, CHORD_PRESS));
+	edge(1000, BTN_1, true);
+	edge(1030, BTN_3, true);
+	edge(1200, BTN_1, false);
+	edge(1220, BTN_3, false);
+	run_to(2000);
+	expect("chord accepted", (BTN_event_t[]) { EVENT(BTN_1, CHORD_PRESS) }, 1);
+
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_1, true);
+	edge(1030, BTN_3, true);
+	edge(1200, BTN_1, false);
+	edge(1220, BTN_3, false);
+	run_to(2000);
+	expect("chord not accepted", (BTN_event_t[]) { EVENT(BTN_1, SINGLE_PRESS), EVENT(BTN_3, SINGLE_PRESS) }, 2);
+
+	// BTN3 held for power off while BTN2 stays down: each hold is timed
+	// from its own press
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_2, true);
+	edge(2000, BTN_3, true);
+	run_to(2600);
+	expect("first hold", (BTN_event_t[]) { EVENT(BTN_2, LONG_PRESS) }, 1);
+	run_to(3600);
+	expect("hold while another is down", (BTN_event_t[]) { EVENT(BTN_3, LONG_PRESS) }, 1);
+	edge(3700, BTN_3, false);
+	edge(3800, BTN_2, false);
+	run_to(4500);
+	expect("held buttons release quietly", NULL, 0);
+
+	// BTN1 spent on its own long press, then BTN3 held on top of it
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_1, true);
+	run_to(3000);
+	edge(3000, BTN_3, true);
+	run_to(4600);
+	edge(4700, BTN_3, false);
+	edge(4800, BTN_1, false);
+	run_to(5500);
+	expect("hold after a hold", (BTN_event_t[]) { EVENT(BTN_1, LONG_PRESS), EVENT(BTN_3, LONG_PRESS) }, 2);
+
+	// A tap finished before a hold completes is reported first
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_1, true);
+	edge(1100, BTN_2, true);
+	edge(1200, BTN_2, false);
+	run_to(2600);
+	edge(2700, BTN_1, false);
+	run_to(3500);
+	expect("tap then hold", (BTN_event_t[]) { EVENT(BTN_2, SINGLE_PRESS), EVENT(BTN_1, LONG_PRESS) }, 2);
+
+	// The menu stops accepting the double press while BTN2 waits for a
+	// second tap: the input side is woken and the single goes out on that
+	// tick, not when the 300 ms gap runs out
+	uint32_t owner_flags = 0;
+	setup(SINGLES_AND_LONGS | BTN_EVENT_BIT(BTN_2, DOUBLE_PRESS));
+	Gesture_set_owner(&gesture, &owner_flags, 0x04U);
+	edge(1000, BTN_2, true);
+	edge(1100, BTN_2, false);
+	run_to(1150);
+	expect("double press still possible", NULL, 0);
+	Gesture_set_accepted(&gesture, BTN_EVENTS_ALL);
+	Gesture_set_accepted(&gesture, SINGLES_AND_LONGS);
+	if (owner_flags != 0x04U) {
+		printf("FAIL owner not woken when the accepted set shrank\n");
+		failures++;
+	}
+	run_to(1151);
+	expect("accepted set shrank", (BTN_event_t[]) { EVENT(BTN_2, SINGLE_PRESS) }, 1);
+
+	// A lone tap is unaffected
+	setup(SINGLES_AND_LONGS);
+	edge(1000, BTN_2, true);
+	edge(1100, BTN_2, false);
+	run_to(2000);
+	expect("single press", (BTN_event_t[]) { EVENT(BTN_2, SINGLE_PRESS) }, 1);
+
+	return (failures == 0) ? 0 : 1;
+}
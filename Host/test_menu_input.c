@@ -0,0 +1,132 @@
+/*
+ * test_menu_input.c
+ *
+ *  Created on: 03-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+// Menu and Gesture wired as MenuLogicTask wires them: events are drained
+// into the menu, then the menu's accepted set is published back. Checks
+// multi-press gestures on pages where the speculative single press leaves
+// the page. Times are in ms, fed as us.
+
+#include "port_host.h"
+#include "Gesture.h"
+#include <stdio.h>
+
+#define MS(t) ((uint32_t) (t) * 1000U)
+#define TAP(btn) GESTURE_TAP(BTN_MASK(btn))
+// Same table as the firmware (freertos.c)
+#define CLICKS(btn) \
+	{ .id = (btn), .type = SINGLE_PRESS, .length = 1, .strokes = { TAP(btn) } }, \
+	{ .id = (btn), .type = DOUBLE_PRESS, .length = 2, .strokes = { TAP(btn), TAP(btn) }, \
+	  .gap_ms = 300, .window_ms = 500 }, \
+	{ .id = (btn), .type = TRIPLE_PRESS, .length = 3, .strokes = { TAP(btn), TAP(btn), TAP(btn) }, \
+	  .gap_ms = 200, .window_ms = 700 }, \
+	{ .id = (btn), .type = LONG_PRESS, .length = 1, .strokes = { GESTURE_HOLD(BTN_MASK(btn)) } }
+
+static const Gesture_def_t table[] = {
+	CLICKS(BTN_1),
+	CLICKS(BTN_2),
+	CLICKS(BTN_3),
+	{ .id = BTN_1, .type = CHORD_PRESS, .length = 1,
+	  .strokes = { GESTURE_TAP(BTN_MASK(BTN_1) | BTN_MASK(BTN_3)) } },
+};
+
+static Menu_t menu;
+static Display_channel_t channel;
+static Gesture_t gesture;
+static EventRing_t ring;
+static uint32_t ring_buffer[16];
+static uint32_t clock_ms;
+static int failures;
+
+#define CHECK(cond) do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __func__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+// What MenuLogicTask does on every wake
+static void drain(void) {
+	BTN_event_t event;
+
+	while (Gesture_receive(&gesture, &event)) {
+		Menu_process_input(&menu, event);
+	}
+	Gesture_set_accepted(&gesture, Menu_accepted_events(&menu));
+}
+
+static void run_to(uint32_t t) {
+	while (clock_ms < t) {
+		clock_ms++;
+		Gesture_tick(&gesture, MS(clock_ms));
+		drain();
+	}
+}
+
+static void tap(uint32_t t, BTN_id_e id) {
+	run_to(t);
+	Gesture_edge(&gesture, id, true, MS(t));
+	drain();
+	run_to(t + 80);
+	Gesture_edge(&gesture, id, false, MS(t + 80));
+	drain();
+}
+
+static void setup(void) {
+	Host_display_channel_ctor(&channel);
+	Menu_ctor(&menu, &channel, NULL);
+	EventRing_ctor(&ring, ring_buffer, 16);
+	Gesture_ctor(&gesture, table, sizeof(table) / sizeof(table[0]), NULL, NULL, &ring);
+	Gesture_set_accepted(&gesture, Menu_accepted_events(&menu));
+	clock_ms = 1000;
+}
+
+// Brightness -> mode select -> manual/auto choice -> auto -> auto mode
+static void enter_auto_mode(void) {
+	tap(1000, BTN_1);
+	tap(1500, BTN_2);
+	if (menu.current_page == MODE_MANUAL_PAGE) {
+		tap(2000, BTN_1);
+	}
+	tap(2500, BTN_2);
+	run_to(3000);
+}
+
+static void test_next_script(void) {
+	setup();
+	enter_auto_mode();
+	CHECK(menu.current_page == AUTO_MODE && Menu_is_auto_mode_active(&menu));
+	uint8_t script = menu.settings.auto_script;
+
+	// The first tap is applied speculatively and leaves AUTO_MODE; the
+	// double press still replaces it
+	tap(3000, BTN_1);
+	tap(3200, BTN_1);
+	run_to(4000);
+	CHECK(menu.current_page == AUTO_MODE && Menu_is_auto_mode_active(&menu));
+	CHECK(menu.settings.auto_script == script + 1);
+	CHECK(!menu.speculation.is_active);
+}
+
+static void test_exit_auto(void) {
+	setup();
+	enter_auto_mode();
+
+	// A lone tap is confirmed once the gap runs out
+	tap(3000, BTN_1);
+	run_to(4000);
+	CHECK(menu.current_page == MODE_MANUAL_PAGE && !Menu_is_auto_mode_active(&menu));
+	CHECK(!menu.speculation.is_active);
+	CHECK((Menu_accepted_events(&menu) & BTN_EVENT_BIT(BTN_1, DOUBLE_PRESS)) == 0);
+}
+
+int main(void) {
+	test_next_script();
+	test_exit_auto();
+
+	printf("%s: %d failures\n", (failures == 0) ? "ok" : "FAIL", failures);
+	return (failures == 0) ? 0 : 1;
+}
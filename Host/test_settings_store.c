@@ -0,0 +1,310 @@
+/*
+ * test_settings_store.c
+ *
+ *  Created on: 02-Feb-2026
+ *      Author: Priyanshu Roy
+ */
+
+// SettingsStore against RAM-backed flash banks: coalescing, bank switches,
+// resets during an erase or a program, and records failing their CRC
+
+#include "SettingsStore.h"
+#include <stdio.h>
+#include <string.h>
+
+#define REGION_SIZE 256     // 16 records per bank, switches quickly
+#define RECORDS (REGION_SIZE / sizeof(SettingsStore_record_t))
+
+// Programming only clears bits, like NOR flash. A program stops before
+// word fail_at_word (-1: never), and an erase with is_erase_torn set stops
+// half way, as a reset would stop them.
+typedef struct {
+	uint8_t mem[SETTINGS_STORE_BANKS][REGION_SIZE];
+	uint32_t erases;
+	int fail_at_word;
+	bool is_erase_torn;
+} Ram_flash_t;
+
+static Ram_flash_t ram;
+static int failures;
+
+#define CHECK(cond) do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __func__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+static bool ram_erase(void *ctx, uint8_t bank) {
+	Ram_flash_t *flash = ctx;
+	if (flash->is_erase_torn) {
+		flash->is_erase_torn = false;
+		memset(flash->mem[bank] + REGION_SIZE / 2, 0xFF, REGION_SIZE / 2);
+		return false;
+	}
+	memset(flash->mem[bank], 0xFF, REGION_SIZE);
+	flash->erases++;
+	return true;
+}
+
+static bool ram_program(void *ctx, uint8_t bank, uint32_t offset, const uint32_t *words,
+		uint32_t count) {
+	Ram_flash_t *flash = ctx;
+	for (uint32_t i = 0; i < count; i++) {
+		if ((int) i == flash->fail_at_word) {
+			flash->fail_at_word = -1;
+			return false;
+		}
+		uint32_t word;
+		memcpy(&word, flash->mem[bank] + offset + i * 4U, sizeof(word));
+		word &= words[i];
+		memcpy(flash->mem[bank] + offset + i * 4U, &word, sizeof(word));
+	}
+	return true;
+}
+
+static const SettingsStore_flash_t region = {
+	.base = { ram.mem[0], ram.mem[1] },
+	.size = REGION_SIZE,
+	.erase = ram_erase,
+	.program = ram_program,
+	.ctx = &ram,
+};
+
+static void blank(void) {
+	memset(ram.mem, 0xFF, sizeof(ram.mem));
+	ram.erases = 0;
+	ram.fail_at_word = -1;
+	ram.is_erase_torn = false;
+}
+
+static void fill(uint8_t *data, uint32_t value) {
+	memset(data, 0, SETTINGS_STORE_DATA_SIZE);
+	memcpy(data, &value, sizeof(value));
+}
+
+// What a reboot would restore
+static bool mount(uint8_t *data, SettingsStore_t *store) {
+	SettingsStore_ctor(store, &region);
+	return SettingsStore_load(store, data);
+}
+
+// Save and let the idle time pass
+static bool write_now(SettingsStore_t *store, uint32_t value, uint32_t *now) {
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	fill(data, value);
+	SettingsStore_save(store, data);
+	SettingsStore_service(store, *now);
+	*now += SETTINGS_STORE_IDLE_MS;
+	return SettingsStore_service(store, *now);
+}
+
+// Bitwise reference for the table-driven CRC-32
+static uint32_t reference_crc32(const uint8_t *bytes, uint32_t length) {
+	uint32_t crc = 0xFFFFFFFFUL;
+	for (uint32_t i = 0; i < length; i++) {
+		crc ^= bytes[i];
+		for (int b = 0; b < 8; b++) {
+			crc = (crc >> 1) ^ ((crc & 1U) ? 0xEDB88320UL : 0U);
+		}
+	}
+	return ~crc;
+}
+
+static void test_blank_region(void) {
+	SettingsStore_t store;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+
+	blank();
+	CHECK(!mount(data, &store));
+	CHECK(store.next == 0);
+}
+
+static void test_coalescing(void) {
+	SettingsStore_t store;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint32_t now = 0;
+
+	blank();
+	mount(data, &store);
+	for (uint32_t i = 1; i <= 5; i++) {
+		fill(data, i);
+		SettingsStore_save(&store, data);
+		CHECK(!SettingsStore_service(&store, now));
+		now += 100;
+	}
+	now += SETTINGS_STORE_IDLE_MS;
+	CHECK(SettingsStore_service(&store, now));
+	CHECK(store.stats.writes == 1 && store.stats.coalesced == 4);
+
+	// Changed and changed back before the idle time: nothing to write
+	fill(data, 9);
+	SettingsStore_save(&store, data);
+	fill(data, 5);
+	SettingsStore_save(&store, data);
+	CHECK(SettingsStore_next_deadline_ms(&store, now) == SETTINGS_STORE_NO_DEADLINE);
+
+	SettingsStore_t rebooted;
+	uint8_t restored[SETTINGS_STORE_DATA_SIZE];
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+
+	const SettingsStore_record_t *record = (const SettingsStore_record_t*) ram.mem[0];
+	CHECK(record->crc == reference_crc32(ram.mem[0], sizeof(*record) - sizeof(uint32_t)));
+}
+
+static void test_wraparound(void) {
+	SettingsStore_t store;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint32_t now = 0;
+
+	blank();
+	mount(data, &store);
+	for (uint32_t i = 0; i < 3 * RECORDS + 5; i++) {
+		CHECK(write_now(&store, 100 + i, &now));
+
+		SettingsStore_t rebooted;
+		uint8_t restored[SETTINGS_STORE_DATA_SIZE];
+		fill(data, 100 + i);
+		CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+		CHECK(rebooted.bank == store.bank && rebooted.next == store.next);
+		CHECK(rebooted.stats.erases == store.stats.erases);
+		CHECK(rebooted.stats.probes <= 2 * (5 + 1));
+	}
+	CHECK(ram.erases == 3 && store.stats.erases == 3 && store.bank == 1);
+}
+
+// Fill the current bank so the next write switches
+static void fill_bank(SettingsStore_t *store, uint32_t *now) {
+	uint32_t value = 1000;
+	while (store->next + sizeof(SettingsStore_record_t) <= REGION_SIZE) {
+		CHECK(write_now(store, value++, now));
+	}
+}
+
+static void test_reset_during_switch(void) {
+	SettingsStore_t store;
+	SettingsStore_t rebooted;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint8_t restored[SETTINGS_STORE_DATA_SIZE];
+	uint32_t now = 0;
+
+	// Both banks used once, bank 0 current and full, bank 1 stale
+	blank();
+	mount(data, &store);
+	fill_bank(&store, &now);
+	CHECK(write_now(&store, 6, &now));
+	fill_bank(&store, &now);
+	CHECK(write_now(&store, 7, &now));
+	fill_bank(&store, &now);
+	CHECK(store.bank == 0);
+	fill(data, store.current[0] | (uint32_t) store.current[1] << 8);
+
+	// Reset half way through erasing bank 1: bank 0 still has everything
+	ram.is_erase_torn = true;
+	CHECK(!write_now(&store, 8, &now));
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+	CHECK(rebooted.bank == 0 && rebooted.stats.erases == store.stats.erases);
+
+	// Reset after the erase, before the first record of bank 1 is complete
+	ram.fail_at_word = 3;
+	CHECK(!write_now(&rebooted, 8, &now));
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+	CHECK(rebooted.bank == 0);
+
+	// The switch goes through on the next try
+	CHECK(write_now(&rebooted, 9, &now));
+	fill(data, 9);
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+	CHECK(rebooted.bank == 1 && rebooted.stats.erases == store.stats.erases + 1);
+}
+
+// Records only in bank 1, bank 0 blank: mounted from bank 1
+static void test_single_bank_log(void) {
+	SettingsStore_t store;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint8_t restored[SETTINGS_STORE_DATA_SIZE];
+	uint32_t now = 0;
+
+	blank();
+	mount(data, &store);
+	CHECK(write_now(&store, 0x42, &now));
+	memcpy(ram.mem[1], ram.mem[0], REGION_SIZE);
+	memset(ram.mem[0], 0xFF, REGION_SIZE);
+
+	fill(data, 0x42);
+	CHECK(mount(restored, &store) && memcmp(restored, data, sizeof(data)) == 0);
+	CHECK(store.bank == 1 && store.next == sizeof(SettingsStore_record_t));
+}
+
+static void test_torn_record(void) {
+	SettingsStore_t store;
+	SettingsStore_t rebooted;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint8_t restored[SETTINGS_STORE_DATA_SIZE];
+	uint32_t now = 0;
+
+	blank();
+	mount(data, &store);
+	CHECK(write_now(&store, 1, &now));
+
+	// Reset half way through the record: the CRC was never written
+	ram.fail_at_word = 2;
+	CHECK(!write_now(&store, 2, &now));
+	fill(data, 1);
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+	CHECK(rebooted.next == 2 * sizeof(SettingsStore_record_t));
+
+	// The next write goes past the torn slot
+	CHECK(write_now(&rebooted, 3, &now));
+	fill(data, 3);
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+
+	// A failure on the first word leaves the slot blank, it is used next time
+	ram.fail_at_word = 0;
+	uint32_t next = rebooted.next;
+	CHECK(!write_now(&rebooted, 4, &now));
+	CHECK(rebooted.next == next && rebooted.stats.failures == 1);
+	CHECK(write_now(&rebooted, 5, &now));
+	CHECK(rebooted.next == next + sizeof(SettingsStore_record_t));
+	fill(data, 5);
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+}
+
+static void test_crc_failure(void) {
+	SettingsStore_t store;
+	SettingsStore_t rebooted;
+	uint8_t data[SETTINGS_STORE_DATA_SIZE];
+	uint8_t restored[SETTINGS_STORE_DATA_SIZE];
+	uint32_t now = 0;
+
+	blank();
+	mount(data, &store);
+	CHECK(write_now(&store, 0x11, &now));
+	CHECK(write_now(&store, 0x22, &now));
+
+	// A bit of the latest record's data cleared: falls back to the one before
+	SettingsStore_record_t *latest = (SettingsStore_record_t*) (ram.mem[0] + sizeof(SettingsStore_record_t));
+	latest->data[0] &= (uint8_t) ~0x02U;
+	fill(data, 0x11);
+	CHECK(mount(restored, &rebooted) && memcmp(restored, data, sizeof(data)) == 0);
+
+	// Banks full of records that are not ours restore nothing
+	blank();
+	memset(ram.mem[0], 0x00, 8 * sizeof(SettingsStore_record_t));
+	memset(ram.mem[1], 0x00, 4 * sizeof(SettingsStore_record_t));
+	CHECK(!mount(restored, &rebooted));
+	CHECK(rebooted.bank == 0 && rebooted.next == 8 * sizeof(SettingsStore_record_t));
+}
+
+int main(void) {
+	test_blank_region();
+	test_coalescing();
+	test_wraparound();
+	test_torn_record();
+	test_reset_during_switch();
+	test_single_bank_log();
+	test_crc_failure();
+
+	printf("%s: %d failures\n", (failures == 0) ? "ok" : "FAIL", failures);
+	return (failures == 0) ? 0 : 1;
+}